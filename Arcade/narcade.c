@@ -0,0 +1,88 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ncurses.h>
+
+#include "arcade.h"
+#include "prof.h"
+#include "term.h"
+
+// Every game in one process. The terminal is opened once and a game's init
+// runs the first time it is picked, so its windows, color pairs and tables
+// are still there the next time. Leaving a game comes back to the menu. The
+// games are built with NARCADE_LAUNCHER, which leaves out their mains.
+
+extern const ARCADE_GAME life_game, tetris_game, connect4_game; 
+bool connect4_args(int argc, char **argv); 
+void tetris_print_latency(FILE *f); 
+
+const ARCADE_GAME *games[] = { &life_game, &tetris_game, &connect4_game }; 
+
+#define GAME_COUNT (int) (sizeof(games) / sizeof(games[0]))
+
+const char narcade_title[] = "NArcade"; 
+
+bool ready[GAME_COUNT]; 
+
+void draw_menu(int selected)
+{
+    erase(); 
+    printw("Arrows and Enter or 1-%d to play, F1 to exit", GAME_COUNT); 
+    int y = (LINES - GAME_COUNT) / 2; 
+    mvprintw(y - 2, (COLS - strlen(narcade_title)) / 2, "%s", narcade_title); 
+    for(int i = 0; i < GAME_COUNT; ++i)
+    {
+        char line[40]; 
+        snprintf(line, sizeof(line), "%d  %s", i + 1, games[i]->name); 
+        mvprintw(y + i, (COLS - 20) / 2, "%-20s", line); 
+        if(i == selected) mvchgat(y + i, (COLS - 20) / 2, 20, A_REVERSE, 0, NULL); 
+    }
+    wnoutrefresh(stdscr); 
+    term_frame(); 
+}
+
+// returns the game picked, or -1 to exit
+int pick(int selected)
+{
+    timeout(-1); 
+    while(true)
+    {
+        draw_menu(selected); 
+        int ch = getch(); 
+        if(ch == KEY_F(1) || ch == 'q' || ch == 'Q') return -1; 
+        if(ch == KEY_UP && selected > 0) --selected; 
+        else if(ch == KEY_DOWN && selected < GAME_COUNT - 1) ++selected; 
+        else if(ch == 10 || ch == KEY_ENTER) return selected; 
+        else if(ch >= '1' && ch < '1' + GAME_COUNT) return ch - '1'; 
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // the options are Connect 4's
+    if(!connect4_args(argc, argv)) return 1; 
+    srand(prof_seed()); 
+
+    term_open(); 
+    prof_init(); 
+    arcade_setup(); 
+
+    int selected = 0; 
+    while((selected = pick(selected)) >= 0)
+    {
+        if(!ready[selected])
+        {
+            games[selected]->init(); 
+            ready[selected] = true; 
+        }
+        arcade_play(games[selected]); 
+    }
+
+    for(int i = 0; i < GAME_COUNT; ++i)
+        if(ready[i]) games[i]->shutdown(); 
+    prof_close(); 
+    term_close(); 
+    tetris_print_latency(stdout); 
+    term_print_stats(stdout); 
+}
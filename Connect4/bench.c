@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "solver.h"
+
+// One file per group, every line a string of 1-based columns and the score
+// of the position. Scores follow the usual convention for these test sets:
+// 22 minus the number of stones the winner has played, negative when the
+// player to move loses, 0 for a draw. Groups go from the end of the game to
+// the beginning, easier ones have fewer empty cells.
+const char *groups[] =
+{
+    "positions/end_easy.txt", 
+    "positions/end_medium.txt", 
+    "positions/end_hard.txt", 
+    "positions/middle_easy.txt", 
+    "positions/middle_medium.txt", 
+    "positions/middle_hard.txt", 
+    "positions/begin_easy.txt", 
+    "positions/begin_medium.txt", 
+    "positions/begin_hard.txt", 
+}; 
+
+#define GROUP_COUNT (int) (sizeof(groups) / sizeof(groups[0]))
+
+#define MAX_LINE 128
+
+// solver score to test set score
+int to_test_score(int score)
+{
+    int stones = score > 0 ? SCORE_WIN - score : SCORE_WIN + score; 
+    int s = (BOARD_ROWS * BOARD_COLS + 2 - stones) / 2; 
+    return score > 0 ? s : score < 0 ? -s : 0; 
+}
+
+// returns the number of wrong scores, -1 if the file cannot be read
+int run_group(const char *path, TTABLE *tt, int threads)
+{
+    FILE *f = fopen(path, "r"); 
+    if(!f)
+    {
+        perror(path); 
+        return -1; 
+    }
+
+    char line[MAX_LINE], moves[MAX_LINE]; 
+    int expected, count = 0, wrong = 0; 
+    double secs = 0; 
+    unsigned long long nodes = 0; 
+    while(fgets(line, sizeof(line), f))
+    {
+        if(sscanf(line, "%127s %d", moves, &expected) != 2) continue; 
+
+        POSITION pos; 
+        if(pos_from_moves(&pos, moves) != (int) strlen(moves))
+        {
+            printf("%s: %s is not a playable line\n", path, moves); 
+            ++wrong; 
+            continue; 
+        }
+
+        // every position starts from an empty table so results do not depend on order
+        tt_clear(tt); 
+        SEARCH_RESULT result; 
+        int score = to_test_score(solve(&pos, tt, threads, &result)); 
+        if(score != expected)
+        {
+            printf("%s: %s scored %d, expected %d\n", path, moves, score, expected); 
+            ++wrong; 
+        }
+        secs += result.secs; 
+        nodes += result.nodes; 
+        ++count; 
+    }
+    fclose(f); 
+
+    const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path; 
+    if(count == 0)
+        printf("%-20s %6d\n", name, 0); 
+    else
+        printf("%-20s %6d %12.6f %14.0f %12.0f %6d\n", name, count, secs / count, 
+            (double) nodes / count, secs > 0 ? nodes / secs : 0, wrong); 
+    fflush(stdout); 
+    return wrong; 
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 1; 
+    int opt; 
+    while((opt = getopt(argc, argv, "j:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'j': threads = atoi(optarg); break; 
+            default:
+                fprintf(stderr, "usage: %s [-j threads] [file ...]\n", argv[0]); 
+                fprintf(stderr, "  runs every group under positions/ without files\n"); 
+                return 1; 
+        }
+    }
+
+    const char **files = groups; 
+    int count = GROUP_COUNT; 
+    if(optind < argc)
+    {
+        files = (const char **) argv + optind; 
+        count = argc - optind; 
+    }
+
+    TTABLE *tt = tt_create(DEFAULT_TT_ENTRIES); 
+    int failed = 0; 
+    printf("%-20s %6s %12s %14s %12s %6s\n", "group", "count", "mean s", "mean nodes", "nodes/s", "wrong"); 
+    for(int i = 0; i < count; ++i)
+        if(run_group(files[i], tt, threads) != 0)
+            failed = 1; 
+    tt_destroy(tt); 
+    return failed; 
+}
@@ -0,0 +1,142 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "book.h"
+#include "solver.h"
+
+// the file is mapped read only and searched in place, opening a book costs
+// the same no matter how big it is
+struct BOOK
+{
+    const BOOK_HEADER *header; 
+    const BOOK_ENTRY *entries; 
+    size_t size; 
+}; 
+
+BOOK *book_open(const char *path)
+{
+    if(!BOOK_SUPPORTED) return NULL; 
+
+    int fd = open(path, O_RDONLY); 
+    if(fd < 0) return NULL; 
+
+    struct stat st; 
+    if(fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(BOOK_HEADER))
+    {
+        close(fd); 
+        return NULL; 
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0); 
+    close(fd); 
+    if(map == MAP_FAILED) return NULL; 
+
+    const BOOK_HEADER *header = (const BOOK_HEADER *) map; 
+    if(header->magic != BOOK_MAGIC || header->rows != BOARD_ROWS || header->cols != BOARD_COLS
+        || header->win_length != WIN_LENGTH
+        || header->count != (st.st_size - sizeof(BOOK_HEADER)) / sizeof(BOOK_ENTRY))
+    {
+        munmap(map, st.st_size); 
+        return NULL; 
+    }
+    // lookups jump around, read ahead would only waste page cache
+    madvise(map, st.st_size, MADV_RANDOM); 
+
+    BOOK *book = (BOOK *) malloc(sizeof(BOOK)); 
+    book->header = header; 
+    book->entries = (const BOOK_ENTRY *) (header + 1); 
+    book->size = st.st_size; 
+    return book; 
+}
+
+void book_close(BOOK *book)
+{
+    if(!book) return; 
+    munmap((void *) book->header, book->size); 
+    free(book); 
+}
+
+int book_ply(const BOOK *book)
+{
+    return book->header->ply; 
+}
+
+// a position and its mirror image have the same score
+BITBOARD book_key(const POSITION *pos)
+{
+    BITBOARD key = pos_key(pos); 
+    BITBOARD mirror = pos_mirror(key); 
+    return mirror < key ? mirror : key; 
+}
+
+int book_pack_score(int score)
+{
+    if(score > 0) return SCORE_WIN - score; 
+    if(score < 0) return -(SCORE_WIN + score); 
+    return 0; 
+}
+
+int book_unpack_score(int packed)
+{
+    if(packed > 0) return SCORE_WIN - packed; 
+    if(packed < 0) return -(SCORE_WIN + packed); 
+    return 0; 
+}
+
+bool book_lookup(const BOOK *book, const POSITION *pos, int *score)
+{
+    if(!book || pos->moves > (int) book->header->ply) return false; 
+
+    BITBOARD key = book_key(pos); 
+    size_t lo = 0, hi = book->header->count; 
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2; 
+        BITBOARD k = BOOK_ENTRY_KEY(book->entries[mid]); 
+        if(k == key)
+        {
+            *score = book_unpack_score(BOOK_ENTRY_SCORE(book->entries[mid]));
+            return true; 
+        }
+        if(k < key) lo = mid + 1; 
+        else hi = mid; 
+    }
+    return false; 
+}
+
+// best column from the scores of the positions it leads to, -1 if any of
+// them is missing
+int book_move(const BOOK *book, const POSITION *root, int *score)
+{
+    if(!book || root->moves >= (int) book->header->ply) return -1; 
+
+    POSITION pos = *root; 
+    int me = pos_player(&pos); 
+    int best = -SCORE_INF, best_move = -1; 
+    for(int c = 0; c < BOARD_COLS; ++c)
+    {
+        if(!pos_can_play(&pos, c)) continue; 
+
+        int s; 
+        if(pos_is_win(pos.boards[me] | CELL_MASK(pos.heights[c], c)))
+            s = SCORE_WIN - (pos.moves + 1); 
+        else
+        {
+            pos_play(&pos, c); 
+            bool found = book_lookup(book, &pos, &s); 
+            pos_undo(&pos, c); 
+            if(!found) return -1; 
+            s = -s; 
+        }
+        // prefer the center on ties
+        if(s > best || (s == best && abs(c - BOARD_COLS / 2) < abs(best_move - BOARD_COLS / 2)))
+        {
+            best = s; 
+            best_move = c; 
+        }
+    }
+    if(score) *score = best; 
+    return best_move; 
+}
@@ -0,0 +1,47 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "position.h"
+
+#define BOOK_FILE "connect4.book"
+#define BOOK_MAGIC 0x31304b4f4f423443ull      // "C4BOOK01" on disk
+
+// The file is a header followed by entries sorted by key. Every entry is the
+// smaller of a position's key and its mirrored key shifted up by a byte, with
+// the proven score packed in the low byte: the number of stones on the board
+// once the player to move wins, negated if they lose, 0 for a draw.
+typedef struct BOOK_HEADER
+{
+    uint64_t magic; 
+    uint32_t rows, cols; 
+    uint32_t ply;               // deepest position in the book
+    uint32_t win_length; 
+    uint64_t count; 
+}BOOK_HEADER; 
+
+typedef uint64_t BOOK_ENTRY; 
+
+// entries keep 56 bits of key, bigger boards play without a book
+#define BOOK_SUPPORTED (KEY_BITS <= 56)
+
+#define BOOK_ENTRY_MAKE(key, score) ((key) << 8 | (uint8_t) (int8_t) (score))
+#define BOOK_ENTRY_KEY(e) ((e) >> 8)
+#define BOOK_ENTRY_SCORE(e) ((int) (int8_t) ((e) & 0xFF))
+
+typedef struct BOOK BOOK; 
+
+BOOK *book_open(const char *path); 
+void book_close(BOOK *book); 
+int book_ply(const BOOK *book); 
+
+BITBOARD book_key(const POSITION *pos); 
+int book_pack_score(int score); 
+int book_unpack_score(int packed); 
+
+bool book_lookup(const BOOK *book, const POSITION *pos, int *score); 
+int book_move(const BOOK *book, const POSITION *pos, int *score); 
+
+#endif
@@ -0,0 +1,219 @@
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "client.h"
+#include "solver.h"
+
+// Bot for the match server. Every connection plays many games at once and
+// answers all the games that are waiting in one write. With the default two
+// connections the bot plays itself, which is a load test for the server.
+
+#define BOT_TT_ENTRIES (1 << 20)
+
+typedef struct BOT
+{
+    CLIENT *client; 
+    POSITION *games;    // indexed by game id
+    signed char *colors;    // color played in every game, -1 if not playing it
+    int cap; 
+    int playing, joined; 
+    int wins, draws, losses; 
+}BOT; 
+
+int concurrent = 16; 
+int games_per_bot = 1000; 
+int depth = 4; 
+int random_plies = 2; 
+unsigned int seed = 1; 
+unsigned long moves; 
+TTABLE *tt; 
+
+// games this process played red in, so games against itself count once
+int games; 
+double last_end; 
+
+double get_time()
+{
+    struct timespec ts; 
+    clock_gettime(CLOCK_MONOTONIC, &ts); 
+    return ts.tv_sec + ts.tv_nsec / 1e9; 
+}
+
+void track(BOT *b, uint32_t id)
+{
+    if(id < (uint32_t) b->cap) return; 
+    int cap = b->cap ? b->cap : 64; 
+    while((uint32_t) cap <= id) cap *= 2; 
+    b->games = (POSITION *) realloc(b->games, cap * sizeof(POSITION)); 
+    b->colors = (signed char *) realloc(b->colors, cap); 
+    memset(b->colors + b->cap, -1, cap - b->cap); 
+    b->cap = cap; 
+}
+
+// a few random moves first so the games differ, then a depth limited search
+void play(BOT *b, uint32_t id)
+{
+    POSITION *pos = &b->games[id]; 
+    int col; 
+    if(pos->moves < random_plies)
+    {
+        do
+            col = rand_r(&seed) % BOARD_COLS; 
+        while(!pos_can_play(pos, col)); 
+    }
+    else
+    {
+        SEARCH_LIMITS limits = { .max_depth = depth, .threads = 1 }; 
+        SEARCH_RESULT result; 
+        search(pos, tt, &limits, &result); 
+        col = result.move; 
+    }
+    pos_play(pos, col); 
+    client_send(b->client, MSG_MOVE, col, id); 
+    ++moves; 
+}
+
+void join(BOT *b)
+{
+    while(b->joined < games_per_bot && b->joined - (b->wins + b->draws + b->losses) < concurrent)
+    {
+        client_send(b->client, MSG_JOIN, JOIN_ANY, 0); 
+        ++b->joined; 
+    }
+}
+
+void handle(BOT *b, const MESSAGE *msg)
+{
+    uint32_t id = msg->game; 
+    switch(msg->type)
+    {
+        case MSG_START:
+            track(b, id); 
+            pos_init(&b->games[id]); 
+            b->colors[id] = msg->arg; 
+            ++b->playing; 
+            if(msg->arg == 0) play(b, id); 
+            break; 
+        case MSG_MOVE:
+        {
+            if(id >= (uint32_t) b->cap || b->colors[id] < 0) break; 
+            POSITION *pos = &b->games[id]; 
+            int them = pos_player(pos); 
+            pos_play(pos, msg->arg); 
+            // the server says when the game is over, a move now could land in its next game
+            if(!pos_is_win(pos->boards[them]) && !pos_is_full(pos))
+                play(b, id); 
+            break; 
+        }
+        case MSG_END:
+            if(id >= (uint32_t) b->cap || b->colors[id] < 0) break; 
+            if(b->colors[id] == 0) ++games; 
+            b->colors[id] = -1; 
+            --b->playing; 
+            last_end = get_time(); 
+            if(msg->arg == END_DRAW) ++b->draws; 
+            else if(msg->arg == END_LOSS) ++b->losses; 
+            else ++b->wins; 
+            join(b); 
+            break; 
+        case MSG_ERROR:
+            fprintf(stderr, "error %d about game %u\n", msg->arg, id); 
+            break; 
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = SOCKET_FILE; 
+    int count = 2; 
+    int opt; 
+    while((opt = getopt(argc, argv, "s:c:n:g:d:r:")) != -1)
+    {
+        switch(opt)
+        {
+            case 's': path = optarg; break; 
+            case 'c': count = atoi(optarg); break; 
+            case 'n': concurrent = atoi(optarg); break; 
+            case 'g': games_per_bot = atoi(optarg); break; 
+            case 'd': depth = atoi(optarg); break; 
+            case 'r': random_plies = atoi(optarg); break; 
+            default:
+                fprintf(stderr, "usage: %s [-s socket] [-c connections] [-n games] [-g games] [-d depth] [-r moves]\n", argv[0]); 
+                fprintf(stderr, "  -s file  server socket, default %s\n", SOCKET_FILE); 
+                fprintf(stderr, "  -c n     connections, 2 plays itself\n"); 
+                fprintf(stderr, "  -n n     games every connection plays at once\n"); 
+                fprintf(stderr, "  -g n     games every connection plays in total\n"); 
+                fprintf(stderr, "  -d n     search depth\n"); 
+                fprintf(stderr, "  -r n     random moves at the start of every game\n"); 
+                return 1; 
+        }
+    }
+    if(count < 1 || concurrent < 1) return 1; 
+
+    BOT bots[count]; 
+    struct pollfd fds[count]; 
+    memset(bots, 0, sizeof(bots)); 
+    for(int i = 0; i < count; ++i)
+    {
+        bots[i].client = client_open(path); 
+        if(!bots[i].client)
+        {
+            perror(path); 
+            return 1; 
+        }
+        fds[i].fd = client_fd(bots[i].client); 
+        fds[i].events = POLLIN; 
+    }
+    tt = tt_create(BOT_TT_ENTRIES); 
+
+    double start = get_time(); 
+    for(int i = 0; i < count; ++i)
+    {
+        join(&bots[i]); 
+        client_flush(bots[i].client); 
+    }
+
+    // stops once nothing is being played and nobody answers the last joins
+    while(true)
+    {
+        int n = poll(fds, count, 1000); 
+        if(n < 0) break; 
+        bool playing = false, waiting = false; 
+        for(int i = 0; i < count; ++i)
+        {
+            BOT *b = &bots[i]; 
+            if(fds[i].revents)
+            {
+                MESSAGE msg; 
+                if(!client_recv(b->client, &msg))
+                {
+                    fprintf(stderr, "server closed the connection\n"); 
+                    return 1; 
+                }
+                handle(b, &msg); 
+                while(client_pending(b->client) && client_recv(b->client, &msg))
+                    handle(b, &msg); 
+                client_flush(b->client); 
+            }
+            if(b->playing) playing = true; 
+            if(b->wins + b->draws + b->losses < b->joined) waiting = true; 
+        }
+        if(!playing && (!waiting || n == 0)) break; 
+    }
+    double secs = last_end - start; 
+
+    for(int i = 0; i < count; ++i)
+    {
+        BOT *b = &bots[i]; 
+        printf("connection %d: %d wins, %d draws, %d losses\n", i, b->wins, b->draws, b->losses); 
+        client_close(b->client); 
+    }
+    printf("%d games in %.2f s, %.0f games/s, %.0f moves/s\n", games, secs, 
+        secs > 0 ? games / secs : 0, secs > 0 ? moves / secs : 0); 
+    tt_destroy(tt); 
+    return 0; 
+}
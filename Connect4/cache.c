@@ -0,0 +1,310 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cache.h"
+
+// results waiting for the writer, more than that are dropped rather than
+// making the search wait
+#define QUEUE_SIZE 4096
+#define MAX_PATH 4096
+
+struct CACHE
+{
+    // compacted file, NULL until something has been solved
+    void *map; 
+    size_t size; 
+    const CACHE_HEADER *header; 
+    const uint64_t *index; 
+    const CACHE_ENTRY *entries; 
+
+    // log writer
+    int log_fd; 
+    pthread_t writer; 
+    pthread_mutex_t lock; 
+    pthread_cond_t ready; 
+    CACHE_ENTRY queue[QUEUE_SIZE]; 
+    int head, count; 
+    bool stop; 
+}; 
+
+// splitmix64 finalizer, the top bits pick the bucket
+static uint64_t cache_hash(uint64_t key)
+{
+    key ^= key >> 30; 
+    key *= 0xBF58476D1CE4E5B9ull; 
+    key ^= key >> 27; 
+    key *= 0x94D049BB133111EBull; 
+    key ^= key >> 31; 
+    return key; 
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    uint64_t x = ((const CACHE_ENTRY *) a)->key, y = ((const CACHE_ENTRY *) b)->key; 
+    uint64_t hx = cache_hash(x), hy = cache_hash(y); 
+    if(hx != hy) return hx < hy ? -1 : 1; 
+    return x < y ? -1 : x > y; 
+}
+
+static bool same_variant(const CACHE_HEADER *header)
+{
+    return header->magic == CACHE_MAGIC
+        && header->rows == BOARD_ROWS && header->cols == BOARD_COLS
+        && header->win_length == WIN_LENGTH; 
+}
+
+static bool valid_header(const CACHE_HEADER *header, size_t size)
+{
+    return size >= sizeof(CACHE_HEADER) && same_variant(header)
+        && header->index_bits > 0 && header->index_bits < 40
+        && size == sizeof(CACHE_HEADER) + (((size_t) 1 << header->index_bits) + 1) * sizeof(uint64_t)
+            + header->count * sizeof(CACHE_ENTRY); 
+}
+
+// whole file in memory, NULL if it does not exist
+static void *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb"); 
+    if(!f) return NULL; 
+    fseek(f, 0, SEEK_END); 
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET); 
+    void *data = malloc(*size ? *size : 1); 
+    if(fread(data, 1, *size, f) != *size)
+    {
+        free(data); 
+        data = NULL; 
+    }
+    fclose(f); 
+    return data; 
+}
+
+// true for an empty file or one written by this variant
+static bool own_file(int fd)
+{
+    struct stat st; 
+    if(fstat(fd, &st) != 0) return false; 
+    if(st.st_size == 0) return true; 
+    CACHE_HEADER header; 
+    return pread(fd, &header, sizeof(header), 0) == sizeof(header) && same_variant(&header); 
+}
+
+// Merges the log into the main file, the caller holds the log's exclusive
+// lock. The new file is written next to the old one and renamed over it, so a
+// crash leaves either the old or the new file and the log is only cut back to
+// its header once the merge is in place.
+static void compact(const char *path, int log_fd)
+{
+    struct stat st; 
+    if(fstat(log_fd, &st) != 0 || (size_t) st.st_size < sizeof(CACHE_HEADER) + sizeof(CACHE_ENTRY))
+        return; 
+    size_t added = (st.st_size - sizeof(CACHE_HEADER)) / sizeof(CACHE_ENTRY); 
+    CACHE_ENTRY *log = (CACHE_ENTRY *) malloc(added * sizeof(CACHE_ENTRY)); 
+    if(pread(log_fd, log, added * sizeof(CACHE_ENTRY), sizeof(CACHE_HEADER)) != (ssize_t) (added * sizeof(CACHE_ENTRY)))
+    {
+        free(log); 
+        return; 
+    }
+
+    size_t old_size = 0, old_count = 0; 
+    char *old = (char *) read_file(path, &old_size); 
+    const CACHE_HEADER *header = (const CACHE_HEADER *) old; 
+    if(old && valid_header(header, old_size))
+        old_count = header->count; 
+
+    size_t n = old_count + added; 
+    CACHE_ENTRY *entries = (CACHE_ENTRY *) malloc(n * sizeof(CACHE_ENTRY)); 
+    if(old_count)
+        memcpy(entries, old + old_size - old_count * sizeof(CACHE_ENTRY), old_count * sizeof(CACHE_ENTRY)); 
+    memcpy(entries + old_count, log, added * sizeof(CACHE_ENTRY)); 
+    free(old); 
+    free(log); 
+
+    // solved scores never change, so any copy of a key will do
+    qsort(entries, n, sizeof(CACHE_ENTRY), compare_entries); 
+    size_t count = 0; 
+    for(size_t i = 0; i < n; ++i)
+        if(count == 0 || entries[i].key != entries[count-1].key)
+            entries[count++] = entries[i]; 
+
+    CACHE_HEADER out = { CACHE_MAGIC, BOARD_ROWS, BOARD_COLS, 1, WIN_LENGTH, count }; 
+    while(((size_t) 1 << out.index_bits) < count && out.index_bits < 32)
+        ++out.index_bits; 
+    size_t buckets = (size_t) 1 << out.index_bits; 
+    uint64_t *index = (uint64_t *) malloc((buckets + 1) * sizeof(uint64_t)); 
+    size_t e = 0; 
+    for(size_t b = 0; b <= buckets; ++b)
+    {
+        while(e < count && (cache_hash(entries[e].key) >> (64 - out.index_bits)) < b)
+            ++e; 
+        index[b] = e; 
+    }
+
+    char tmp_path[MAX_PATH]; 
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path); 
+    FILE *f = fopen(tmp_path, "wb"); 
+    bool ok = f
+        && fwrite(&out, sizeof(out), 1, f) == 1
+        && fwrite(index, sizeof(uint64_t), buckets + 1, f) == buckets + 1
+        && fwrite(entries, sizeof(CACHE_ENTRY), count, f) == count; 
+    if(f && fclose(f) != 0) ok = false; 
+    if(ok && rename(tmp_path, path) == 0)
+        ftruncate(log_fd, sizeof(CACHE_HEADER)); 
+    else
+        unlink(tmp_path); 
+    free(index); 
+    free(entries); 
+}
+
+static void *write_log(void *pargs)
+{
+    CACHE *cache = (CACHE *) pargs; 
+    CACHE_ENTRY batch[QUEUE_SIZE]; 
+    while(true)
+    {
+        pthread_mutex_lock(&cache->lock); 
+        while(cache->count == 0 && !cache->stop)
+            pthread_cond_wait(&cache->ready, &cache->lock); 
+        int n = cache->count; 
+        for(int i = 0; i < n; ++i)
+            batch[i] = cache->queue[(cache->head + i) % QUEUE_SIZE]; 
+        cache->head = (cache->head + n) % QUEUE_SIZE; 
+        cache->count = 0; 
+        bool stop = cache->stop; 
+        pthread_mutex_unlock(&cache->lock); 
+
+        // whole records only, a short write would shift every later one
+        bool ok = true; 
+        if(n)
+        {
+            flock(cache->log_fd, LOCK_SH); 
+            ok = write(cache->log_fd, batch, n * sizeof(CACHE_ENTRY)) == (ssize_t) (n * sizeof(CACHE_ENTRY)); 
+            flock(cache->log_fd, LOCK_UN); 
+        }
+        if(!ok) break; 
+        if(stop) break; 
+    }
+    return NULL; 
+}
+
+CACHE *cache_open(const char *path)
+{
+    if(!CACHE_SUPPORTED) return NULL; 
+
+    char log_path[MAX_PATH]; 
+    snprintf(log_path, sizeof(log_path), "%s.log", path); 
+    int log_fd = open(log_path, O_RDWR | O_CREAT | O_APPEND, 0644); 
+    if(log_fd < 0) return NULL; 
+
+    // files of another variant are neither merged nor overwritten
+    flock(log_fd, LOCK_EX); 
+    int main_fd = open(path, O_RDONLY); 
+    bool own = own_file(log_fd) && (main_fd < 0 || own_file(main_fd)); 
+    if(main_fd >= 0) close(main_fd); 
+    if(own && lseek(log_fd, 0, SEEK_END) == 0)
+    {
+        CACHE_HEADER header = { CACHE_MAGIC, BOARD_ROWS, BOARD_COLS, 0, WIN_LENGTH, 0 }; 
+        own = write(log_fd, &header, sizeof(header)) == sizeof(header); 
+    }
+    if(own) compact(path, log_fd); 
+    flock(log_fd, LOCK_UN); 
+    if(!own)
+    {
+        close(log_fd); 
+        return NULL; 
+    }
+
+    CACHE *cache = (CACHE *) calloc(1, sizeof(CACHE)); 
+    cache->log_fd = log_fd; 
+
+    int fd = open(path, O_RDONLY); 
+    struct stat st; 
+    if(fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0); 
+        if(map != MAP_FAILED && valid_header((const CACHE_HEADER *) map, st.st_size))
+        {
+            madvise(map, st.st_size, MADV_RANDOM); 
+            cache->map = map; 
+            cache->size = st.st_size; 
+            cache->header = (const CACHE_HEADER *) map; 
+            cache->index = (const uint64_t *) (cache->header + 1); 
+            cache->entries = (const CACHE_ENTRY *) (cache->index + ((size_t) 1 << cache->header->index_bits) + 1); 
+        }
+        else if(map != MAP_FAILED)
+            munmap(map, st.st_size); 
+    }
+    if(fd >= 0) close(fd); 
+
+    pthread_mutex_init(&cache->lock, NULL); 
+    pthread_cond_init(&cache->ready, NULL); 
+    pthread_create(&cache->writer, NULL, write_log, cache); 
+    return cache; 
+}
+
+void cache_close(CACHE *cache)
+{
+    if(!cache) return; 
+
+    pthread_mutex_lock(&cache->lock); 
+    cache->stop = true; 
+    pthread_cond_signal(&cache->ready); 
+    pthread_mutex_unlock(&cache->lock); 
+    pthread_join(cache->writer, NULL); 
+
+    fsync(cache->log_fd); 
+    close(cache->log_fd); 
+    if(cache->map) munmap(cache->map, cache->size); 
+    pthread_mutex_destroy(&cache->lock); 
+    pthread_cond_destroy(&cache->ready); 
+    free(cache); 
+}
+
+unsigned long cache_size(const CACHE *cache)
+{
+    return cache && cache->header ? cache->header->count : 0; 
+}
+
+bool cache_lookup(const CACHE *cache, BITBOARD key, int *score, int *move)
+{
+    if(!cache || !cache->header) return false; 
+
+    uint64_t b = cache_hash((uint64_t) key) >> (64 - cache->header->index_bits); 
+    for(uint64_t i = cache->index[b]; i < cache->index[b+1]; ++i)
+    {
+        if(cache->entries[i].key == (uint64_t) key)
+        {
+            *score = cache->entries[i].score;
+            *move = cache->entries[i].move;
+            return true; 
+        }
+    }
+    return false; 
+}
+
+void cache_add(CACHE *cache, BITBOARD key, int score, int move)
+{
+    if(!cache) return; 
+
+    CACHE_ENTRY e; 
+    memset(&e, 0, sizeof(e)); 
+    e.key = (uint64_t) key; 
+    e.score = score; 
+    e.move = move; 
+
+    pthread_mutex_lock(&cache->lock); 
+    if(cache->count < QUEUE_SIZE)
+    {
+        cache->queue[(cache->head + cache->count) % QUEUE_SIZE] = e; 
+        ++cache->count; 
+        pthread_cond_signal(&cache->ready); 
+    }
+    pthread_mutex_unlock(&cache->lock); 
+}
@@ -0,0 +1,51 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+
+#include "position.h"
+
+#define CACHE_FILE VARIANT_NAME ".cache"
+#define CACHE_MAGIC 0x3145484341433443ull     // "C4CACHE1" on disk
+
+// Exact scores of solved positions kept between runs. New results go to an
+// append only log written by a background thread. Opening the cache folds the
+// log into the main file, which is sorted by key hash with a bucket index in
+// front and mapped read only, so lookups are a few loads with no locking.
+// Both files start with a header naming the variant, a cache written by
+// another variant is left alone and the game runs without one. Every process
+// appends under a shared flock of the log and compacts under an exclusive one.
+typedef struct CACHE_HEADER
+{
+    uint64_t magic; 
+    uint32_t rows, cols; 
+    uint32_t index_bits;        // the index has 2^index_bits + 1 offsets
+    uint32_t win_length; 
+    uint64_t count; 
+}CACHE_HEADER; 
+
+typedef struct CACHE_ENTRY
+{
+    uint64_t key; 
+    int16_t score; 
+    int8_t move; 
+    uint8_t pad[5]; 
+}CACHE_ENTRY; 
+
+// keys up to this long are stored exactly in the solver's table, longer ones
+// are hashed and a collision could keep a wrong score in the cache for good
+#define TT_EXACT_BITS 54
+
+// bigger boards run without a cache
+#define CACHE_SUPPORTED (KEY_BITS <= TT_EXACT_BITS)
+
+typedef struct CACHE CACHE; 
+
+CACHE *cache_open(const char *path); 
+void cache_close(CACHE *cache); 
+unsigned long cache_size(const CACHE *cache); 
+
+bool cache_lookup(const CACHE *cache, BITBOARD key, int *score, int *move); 
+void cache_add(CACHE *cache, BITBOARD key, int score, int move); 
+
+#endif
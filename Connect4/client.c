@@ -0,0 +1,103 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "client.h"
+
+#define BATCH 512
+
+struct CLIENT
+{
+    int fd; 
+    MESSAGE out[BATCH]; 
+    int out_count; 
+    // a read can end in the middle of a message, the rest comes with the next
+    uint8_t in[BATCH * sizeof(MESSAGE)]; 
+    size_t in_start, in_end; 
+}; 
+
+CLIENT *client_open(const char *path)
+{
+    struct sockaddr_un addr; 
+    memset(&addr, 0, sizeof(addr)); 
+    addr.sun_family = AF_UNIX; 
+    if(strlen(path) >= sizeof(addr.sun_path)) return NULL; 
+    strcpy(addr.sun_path, path); 
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0); 
+    if(fd < 0) return NULL; 
+    if(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        close(fd); 
+        return NULL; 
+    }
+    CLIENT *client = (CLIENT *) calloc(1, sizeof(CLIENT)); 
+    client->fd = fd; 
+    return client; 
+}
+
+void client_close(CLIENT *client)
+{
+    if(!client) return; 
+    client_flush(client); 
+    close(client->fd); 
+    free(client); 
+}
+
+int client_fd(const CLIENT *client)
+{
+    return client->fd; 
+}
+
+void client_send(CLIENT *client, int type, int arg, uint32_t game)
+{
+    if(client->out_count == BATCH) client_flush(client); 
+    MESSAGE *msg = &client->out[client->out_count++]; 
+    msg->type = type; 
+    msg->arg = arg; 
+    msg->pad = 0; 
+    msg->game = game; 
+}
+
+bool client_flush(CLIENT *client)
+{
+    const uint8_t *p = (const uint8_t *) client->out; 
+    size_t left = client->out_count * sizeof(MESSAGE); 
+    client->out_count = 0; 
+    while(left)
+    {
+        ssize_t n = write(client->fd, p, left); 
+        if(n <= 0) return false; 
+        p += n; 
+        left -= n; 
+    }
+    return true; 
+}
+
+bool client_pending(const CLIENT *client)
+{
+    return client->in_end - client->in_start >= sizeof(MESSAGE); 
+}
+
+bool client_recv(CLIENT *client, MESSAGE *msg)
+{
+    while(!client_pending(client))
+    {
+        // the answer may depend on what is still queued
+        if(client->out_count && !client_flush(client)) return false; 
+
+        // keep the partial message at the front and fill the rest
+        size_t partial = client->in_end - client->in_start; 
+        memmove(client->in, client->in + client->in_start, partial); 
+        client->in_start = 0; 
+        client->in_end = partial; 
+        ssize_t n = read(client->fd, client->in + partial, sizeof(client->in) - partial); 
+        if(n <= 0) return false; 
+        client->in_end += n; 
+    }
+    memcpy(msg, client->in + client->in_start, sizeof(MESSAGE)); 
+    client->in_start += sizeof(MESSAGE); 
+    return true; 
+}
@@ -0,0 +1,26 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "protocol.h"
+
+// Connection to a match server. Sends are queued until client_flush, so a
+// bot can answer every game that is waiting with one write, and reads take
+// whatever has arrived at once.
+typedef struct CLIENT CLIENT; 
+
+CLIENT *client_open(const char *path); 
+void client_close(CLIENT *client); 
+int client_fd(const CLIENT *client); 
+
+void client_send(CLIENT *client, int type, int arg, uint32_t game); 
+bool client_flush(CLIENT *client); 
+
+// next message, flushes and waits unless client_pending, false once the
+// server is gone
+bool client_recv(CLIENT *client, MESSAGE *msg); 
+bool client_pending(const CLIENT *client); 
+
+#endif
@@ -1,88 +1,206 @@
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <unistd.h>
-#include <pthread.h>
 #include <ncurses.h>
+#include <poll.h>
+#include <pthread.h>
 
-#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
-
-#define BOARD_ROWS 6
-#define BOARD_COLS 7
-
-#define RED 1
-#define YELLOW 2
-
-WINDOW *game_win; 
+#include "book.h"
+#include "arcade.h"
+#include "cache.h"
+#include "canvas.h"
+#include "client.h"
+#include "position.h"
+#include "prof.h"
+#include "solver.h"
+#include "term.h"
+#include "threats.h"
+
+// color pairs, after the ones Tetris uses, as the launcher runs both
+#define RED 8
+#define YELLOW 9
+
+// the computer thinks for a tenth of its budget over the first OPENING_MOVES
+#define OPENING_MOVES 4
+
+// animation timing, chips fall with constant acceleration in screen lines
+#define FRAME_SECS 0.016
+#define FALL_ACCEL 400.0
+#define BLINK_SECS 0.5
+#define RESET_ROW_SECS 0.15
+
+// keys typed during an animation wait for it to finish
+#define MAX_PENDING 8
+
+WINDOW *c4_win; 
+CANVAS *c4_canvas;  // every frame is drawn whole into it, only changes go out
+WINDOW *msg_win;    // the result and the menu, under the board
+CANVAS *msg_canvas; 
 int GAME_LINES, GAME_COLS; 
 int GAME_START_Y, GAME_START_X; 
-const char title[] = "Connect 4"; 
+const char c4_title[] = "Connect " XSTR(WIN_LENGTH); 
 
 int BOARD_HEIGHT, BOARD_WIDTH; 
 int CHIP_HEIGHT, CHIP_WIDTH; 
 int SEP_HEIGHT, SEP_WIDTH; 
 int OFFSET_Y, OFFSET_X; 
 
-typedef struct CHIP 
+// screen position of every cell, row 0 is the top of the board 
+typedef struct LAYOUT 
 {
     int y, x; 
-    int c; 
-}CHIP;
-
-void setup(); 
-
-void draw_board(const CHIP [BOARD_ROWS][BOARD_COLS]); 
-
-CHIP *play(CHIP [BOARD_ROWS][BOARD_COLS]); 
-void print_win_msg(int c); 
-
-bool play_again(); 
-void reset(CHIP [BOARD_ROWS][BOARD_COLS]); 
-void *blink(void *); 
-
-void cleanup(); 
+}LAYOUT; 
+
+LAYOUT layout[BOARD_ROWS][BOARD_COLS]; 
+
+// player the computer plays as, -1 for two humans
+int ai_player = -1; 
+int ai_time_ms = 1000; 
+int ai_threads = 1; 
+TTABLE *tt; 
+const char *book_path = BOOK_FILE; 
+BOOK *book; 
+const char *cache_path = CACHE_FILE; 
+CACHE *cache; 
+
+// searching the player's likely replies while they decide, the main thread
+// only starts, cancels and joins it
+pthread_t ponder_thread; 
+bool pondering; 
+atomic_bool ponder_cancel; 
+POSITION ponder_pos; 
+double ponder_secs[BOARD_COLS];     // time spent on the reply in every column
+
+// playing someone on a match server instead of the computer
+const char *server_path; 
+CLIENT *server; 
+int net_player = -1;        // color of the other side, -1 until a game starts
+uint32_t net_game; 
+int net_move = -1;          // their move, played once our chip has landed
+
+// everything the event loop moves between, only the main thread draws
+typedef enum STATE
+{
+    STATE_PLAY,         // waiting for the player to move
+    STATE_FALL,         // a chip is falling into its column
+    STATE_OVER,         // game won or tied, asking to play again
+    STATE_RESET         // rows dropping out of the board
+}STATE; 
 
-int main() 
+typedef struct GAME
+{
+    POSITION pos; 
+    STATE state; 
+    int col;            // column of the chip above the board
+    BITBOARD win_cells; 
+    bool blink_on; 
+    bool again;         // play again is selected
+    bool hints;         // threats are shown on the board
+    bool quit;          // the player left
+    const char *result; // shown under the board once the game is over
+    double start;       // when the chip started falling
+    double next;        // next timer, 0 for none
+    int pending[MAX_PENDING]; 
+    int npending; 
+}GAME; 
+
+GAME game; 
+
+void connect4_init(); 
+void connect4_start(); 
+int connect4_tick(); 
+int connect4_render(); 
+void connect4_shutdown(); 
+
+const ARCADE_GAME connect4_game = {
+    "Connect " XSTR(WIN_LENGTH), 
+    connect4_init, 
+    connect4_start, 
+    connect4_tick, 
+    connect4_render, 
+    connect4_shutdown
+}; 
+
+void draw_board(const POSITION *); 
+
+void shift_down(POSITION *); 
+bool is_empty(const POSITION *); 
+
+void net_join(); 
+
+int player_color(int player)
 {
-    setup(); 
+    return player == 0 ? COLOR_PAIR(RED) : COLOR_PAIR(YELLOW); 
+}
 
-    CHIP board[BOARD_ROWS][BOARD_COLS]; 
-    for(int i = 0; i < BOARD_ROWS; ++i)
-        for(int j = 0; j < BOARD_COLS; ++j)
+bool parse_args(int argc, char **argv)
+{
+    int opt; 
+    while((opt = getopt(argc, argv, "ryt:j:b:c:s:")) != -1)
+    {
+        switch(opt)
         {
-            board[i][j].y = OFFSET_Y + ((i+1) * CHIP_HEIGHT) + ((i+1) * SEP_HEIGHT); 
-            board[i][j].x = OFFSET_X + (j * CHIP_WIDTH) + (j * SEP_WIDTH); 
-            board[i][j].c = A_REVERSE; 
+            case 'r': ai_player = 0; break; 
+            case 'y': ai_player = 1; break; 
+            case 't': ai_time_ms = atoi(optarg); break; 
+            case 'j': ai_threads = atoi(optarg); break; 
+            case 'b': book_path = optarg; break; 
+            case 'c': cache_path = optarg; break; 
+            case 's': server_path = optarg; break; 
+            default: return false; 
         }
+    }
+    // the other side is on the server
+    return !server_path || ai_player < 0; 
+}
 
-    pthread_t id; 
-    do
+// opens what the options ask for, returns false after printing the usage or
+// the error
+bool connect4_args(int argc, char **argv)
+{
+    if(!parse_args(argc, argv))
+    {
+        fprintf(stderr, "usage: %s [-r | -y] [-t ms] [-j threads] [-b book] [-c cache] | [-s socket]\n", argv[0]); 
+        fprintf(stderr, "  -r, -y   computer plays red or yellow\n"); 
+        fprintf(stderr, "  -t ms    computer think time per move\n"); 
+        fprintf(stderr, "  -j n     search threads\n"); 
+        fprintf(stderr, "  -b file  opening book, default %s\n", BOOK_FILE); 
+        fprintf(stderr, "  -c file  solved positions kept between games, default %s\n", CACHE_FILE); 
+        fprintf(stderr, "  -s file  play someone on a match server, usually %s\n", SOCKET_FILE); 
+        return false; 
+    }
+    if(server_path)
     {
-        CHIP *win_chips; 
-        win_chips = play(board);  
-        if(win_chips != NULL)
-            print_win_msg(win_chips[0].c); 
-        else 
-            print_win_msg(-1); 
-        refresh(); 
-
-        pthread_create(&id, NULL, blink, (void *) win_chips); 
-        if(!play_again())
+        server = client_open(server_path); 
+        if(!server)
         {
-            if(win_chips != NULL) free(win_chips); 
-            break; 
+            perror(server_path); 
+            return false; 
         }
-        pthread_cancel(id); 
-        move(GAME_START_Y + GAME_LINES, 0);
-        clrtoeol(); 
-        refresh(); 
-        reset(board); 
-    }while(true); 
-    
-    cleanup(); 
+    }
+    if(ai_player >= 0)
+    {
+        tt = tt_create(DEFAULT_TT_ENTRIES); 
+        // playing without a book is fine, it only saves thinking time
+        book = book_open(book_path); 
+        cache = cache_open(cache_path); 
+        tt_set_cache(tt, cache); 
+    }
+    return true; 
 }
 
+#ifndef NARCADE_LAUNCHER
+int main(int argc, char **argv) 
+{
+    if(!connect4_args(argc, argv)) return 1; 
+    arcade_main(&connect4_game); 
+}
+#endif
+
 void init_pairs() 
 {
     init_pair(RED, -1, COLOR_RED); 
@@ -111,300 +229,561 @@ void calculate()
     OFFSET_X = (GAME_COLS - BOARD_WIDTH) / 2; 
 }
 
-void setup()
+void connect4_init()
 {
-    initscr(); 
-    refresh(); 
-    cbreak(); 
-    noecho(); 
-    curs_set(0); 
-    keypad(stdscr, TRUE); 
-
-    start_color(); 
-    use_default_colors();  
     init_pairs(); 
-
     calculate(); 
-    game_win = newwin(GAME_LINES, GAME_COLS, GAME_START_Y, GAME_START_X); 
-    printw("PRESS F1 to exit"); 
-    mvprintw(GAME_START_Y-1, GAME_START_X + (GAME_COLS - strlen(title)) / 2, "%s", title); 
-    refresh(); 
-    keypad(game_win, TRUE); 
+    c4_win = newwin(GAME_LINES, GAME_COLS, GAME_START_Y, GAME_START_X); 
+    c4_canvas = canvas_create(c4_win); 
+    msg_win = newwin(LINES - (GAME_START_Y + GAME_LINES), GAME_COLS, GAME_START_Y + GAME_LINES, GAME_START_X); 
+    msg_canvas = canvas_create(msg_win); 
+    keypad(c4_win, TRUE); 
+
+    for(int i = 0; i < BOARD_ROWS; ++i)
+        for(int j = 0; j < BOARD_COLS; ++j)
+        {
+            layout[i][j].y = OFFSET_Y + ((i+1) * CHIP_HEIGHT) + ((i+1) * SEP_HEIGHT); 
+            layout[i][j].x = OFFSET_X + (j * CHIP_WIDTH) + (j * SEP_WIDTH); 
+        }
+}
+
+void connect4_start()
+{
+    erase(); 
+    printw("PRESS F1 to exit, H for hints, P for frame times"); 
+    mvprintw(GAME_START_Y-1, GAME_START_X + (GAME_COLS - strlen(c4_title)) / 2, "%s", c4_title); 
+    // shown with the first frame
+    wnoutrefresh(stdscr); 
+    canvas_invalidate(c4_canvas); 
+    canvas_invalidate(msg_canvas); 
+
+    memset(&game, 0, sizeof(GAME)); 
+    pos_init(&game.pos); 
+    if(server) net_join(); 
 }
 
 void draw_rect(int attr, int height, int width, int starty, int startx)
 {
-    wattrset(game_win, attr); 
-    for(int i = 0; i < height; ++i)
-        mvwhline(game_win, starty + i, startx, ' ', width); 
-    wattrset(game_win, A_NORMAL); 
+    canvas_fill(c4_canvas, starty, startx, height, width, ' ' | attr); 
 }
 
-void draw_chip(CHIP chip)
+void draw_chip(int i, int j, int c)
 {
-    draw_rect(chip.c, CHIP_HEIGHT, CHIP_WIDTH, chip.y, chip.x); 
+    draw_rect(c, CHIP_HEIGHT, CHIP_WIDTH, layout[i][j].y, layout[i][j].x); 
 }
 
-void erase_chip(CHIP chip)
+void erase_chip(int i, int j)
 {
-    draw_rect(A_NORMAL, CHIP_HEIGHT, CHIP_WIDTH, chip.y, chip.x); 
+    draw_rect(A_NORMAL, CHIP_HEIGHT, CHIP_WIDTH, layout[i][j].y, layout[i][j].x); 
 }
 
-void draw_board(const CHIP board[BOARD_ROWS][BOARD_COLS])
+// empty cells are drawn reversed 
+int cell_color(const POSITION *pos, int i, int j)
 {
-    for(int i = 0; i < BOARD_ROWS; ++i)
-        for(int j = 0; j < BOARD_COLS; ++j)
-            draw_chip(board[i][j]); 
+    int player = pos_at(pos, BOARD_ROWS-1 - i, j); 
+    return player < 0 ? (int) A_REVERSE : player_color(player); 
 }
 
-int get_empty_row(const CHIP board[BOARD_ROWS][BOARD_COLS], int c)
+void draw_board(const POSITION *pos)
 {
-    for(int r = BOARD_ROWS-1; r >= 0; --r)
-        if(board[r][c].c == A_REVERSE)
-            return r; 
-    return -1; 
+    for(int i = 0; i < BOARD_ROWS; ++i)
+        for(int j = 0; j < BOARD_COLS; ++j)
+            draw_chip(i, j, cell_color(pos, i, j)); 
 }
 
-bool is_valid(int r, int c)
+// pondered_secs is how long the position was already searched while the player
+// thought, most of that work is still in the table
+int ai_move(const POSITION *pos, double pondered_secs)
 {
-    return 0 <= r && r < BOARD_ROWS &&
-            0 <= c && c < BOARD_COLS; 
+    int col = book_move(book, pos, NULL); 
+    if(col >= 0) return col; 
+
+    SEARCH_LIMITS limits = { .time_ms = ai_time_ms, .threads = ai_threads }; 
+    limits.time_ms -= (int) (pondered_secs * 1000); 
+    if(limits.time_ms < ai_time_ms / 10) limits.time_ms = ai_time_ms / 10; 
+    if(pos->moves < OPENING_MOVES) limits.time_ms /= 10; 
+    SEARCH_RESULT result; 
+    search(pos, tt, &limits, &result); 
+    return result.move; 
 }
 
-CHIP *get_win(CHIP board[BOARD_ROWS][BOARD_COLS], int r, int c, void (*next) (int *, int *))
+// Fills the table for the positions the computer may have to answer. The
+// player's most likely move goes first, then every other one, over and over
+// with more time each round until the tree is solved or the player moves.
+void *ponder(void *pargs)
 {
-    CHIP *chips = (CHIP *) malloc(4 * sizeof(CHIP)); 
-    int current_color = A_NORMAL; 
-    int n = 0; 
-    while(is_valid(r, c))
+    (void) pargs; 
+    POSITION pos = ponder_pos; 
+    SEARCH_LIMITS limits = { .time_ms = ai_time_ms / 10, .threads = ai_threads, .cancel = &ponder_cancel }; 
+    SEARCH_RESULT result; 
+    search(&pos, tt, &limits, &result); 
+
+    int order[BOARD_COLS], n = 0; 
+    if(result.move >= 0) order[n++] = result.move; 
+    for(int i = 0; i < BOARD_COLS; ++i)
     {
-        if(board[r][c].c != A_REVERSE && board[r][c].c == current_color)
-            chips[n++] = board[r][c]; 
-        else
+        // from the center out
+        int c = BOARD_COLS / 2 + (i & 1 ? (i + 1) / 2 : -(i / 2)); 
+        if(c != result.move && pos_can_play(&pos, c)) order[n++] = c; 
+    }
+
+    int me = pos_player(&pos); 
+    for(limits.time_ms = ai_time_ms; !atomic_load(&ponder_cancel); limits.time_ms *= 2)
+    {
+        bool solved = true; 
+        for(int i = 0; i < n && !atomic_load(&ponder_cancel); ++i)
         {
-            current_color = board[r][c].c; 
-            chips[0] = board[r][c]; 
-            n = 1; 
+            int c = order[i]; 
+            if(pos_is_win(pos.boards[me] | CELL_MASK(pos.heights[c], c))) continue; 
+            pos_play(&pos, c); 
+            if(book_move(book, &pos, NULL) < 0)
+            {
+                search(&pos, tt, &limits, &result); 
+                ponder_secs[c] += result.secs; 
+                solved = solved && result.exact; 
+            }
+            pos_undo(&pos, c); 
         }
-        if(n == 4)
-            return chips; 
-        next(&r, &c); 
+        if(solved) break; 
     }
-    free(chips); 
     return NULL; 
 }
 
-void next_col(int *r, int *c)
+// asks the search to stop, it notices within a few thousand nodes
+void cancel_ponder()
 {
-    ++(*c); 
+    if(pondering) atomic_store(&ponder_cancel, true); 
 }
 
-void next_row(int *r, int *c)
+void stop_ponder()
 {
-    --(*r); 
+    if(!pondering) return; 
+    cancel_ponder(); 
+    pthread_join(ponder_thread, NULL); 
+    pondering = false; 
 }
 
-void next_ldiagonal(int *r, int *c)
+void start_ponder(const POSITION *pos)
 {
-    --(*r); 
-    ++(*c); 
+    if(ai_player < 0) return; 
+    if(pondering && !atomic_load(&ponder_cancel)) return; 
+    stop_ponder(); 
+    ponder_pos = *pos; 
+    memset(ponder_secs, 0, sizeof(ponder_secs)); 
+    atomic_store(&ponder_cancel, false); 
+    pondering = pthread_create(&ponder_thread, NULL, ponder, NULL) == 0; 
 }
 
-void next_rdiagonal(int *r, int *c)
+// time the last ponder spent on pos, reached by the player dropping in col
+double pondered(const POSITION *pos, int col)
 {
-    --(*r); 
-    --(*c); 
+    POSITION p = ponder_pos; 
+    if(!pos_can_play(&p, col)) return 0; 
+    pos_play(&p, col); 
+    return pos_key(&p) == pos_key(pos) ? ponder_secs[col] : 0; 
 }
 
-CHIP *get_all_wins(CHIP board[BOARD_ROWS][BOARD_COLS], int r, int c)
+// the player at the keyboard is to move
+bool human_to_move(const GAME *g)
 {
-    CHIP *horizontal = get_win(board, r, 0, next_col); 
-    if(horizontal != NULL) return horizontal; 
+    int player = pos_player(&g->pos); 
+    if(server) return net_player >= 0 && player != net_player; 
+    return player != ai_player; 
+}
 
-    CHIP *vertical = get_win(board, BOARD_ROWS-1, c, next_row); 
-    if(vertical != NULL) return vertical; 
+void net_join()
+{
+    net_player = -1; 
+    net_move = -1; 
+    client_send(server, MSG_JOIN, JOIN_ANY, 0); 
+    client_flush(server); 
+}
 
-    int lo = MIN(c - 0, BOARD_ROWS-1 - r); 
-    CHIP *left_diagonal = get_win(board, r+lo, c-lo, next_ldiagonal); 
-    if(left_diagonal != NULL) return left_diagonal; 
+// the other side resigned or went away, the game ends like a win
+void net_left(GAME *g)
+{
+    g->state = STATE_OVER; 
+    g->win_cells = 0; 
+    g->blink_on = true; 
+    g->again = true; 
+    g->next = 0; 
+    net_player = -1; 
+    g->result = "Your opponent left"; 
+}
 
-    int ro = MIN(BOARD_COLS-1 - c, BOARD_ROWS-1 - r); 
-    CHIP *right_diagonal = get_win(board, r+ro, c+ro, next_rdiagonal); 
-    if(right_diagonal != NULL) return right_diagonal; 
+void net_handle(GAME *g, const MESSAGE *msg)
+{
+    switch(msg->type)
+    {
+        case MSG_START: 
+            net_game = msg->game; 
+            net_player = msg->arg ^ 1; 
+            break; 
+        case MSG_MOVE: 
+            if(msg->game == net_game && net_player >= 0) net_move = msg->arg; 
+            break; 
+        case MSG_END: 
+            // wins and draws show up on the board by themselves
+            if(msg->game == net_game && msg->arg == END_LEFT && g->state != STATE_OVER) net_left(g); 
+            break; 
+    }
+}
 
-    return NULL; 
+// waits like wgetch, but also for the server, and returns the key or ERR
+int net_wait(GAME *g, int wait)
+{
+    // curses may hold keys it has already read
+    wtimeout(c4_win, 0); 
+    int ch = wgetch(c4_win); 
+    if(ch != ERR) return ch; 
+
+    struct pollfd fds[2] = { { 0, POLLIN, 0 }, { client_fd(server), POLLIN, 0 } }; 
+    if(!client_pending(server)) poll(fds, 2, wait); 
+    if(client_pending(server) || fds[1].revents)
+    {
+        MESSAGE msg; 
+        if(!client_recv(server, &msg))
+        {
+            g->quit = true; 
+            return ERR; 
+        }
+        net_handle(g, &msg); 
+        while(client_pending(server) && client_recv(server, &msg))
+            net_handle(g, &msg); 
+    }
+    return fds[0].revents ? wgetch(c4_win) : ERR; 
 }
 
-bool is_empty(const CHIP board[BOARD_ROWS][BOARD_COLS])
+static double get_time()
 {
-    for(int i = 0; i < BOARD_COLS; ++i)
-        if(board[BOARD_ROWS-1][i].c != A_REVERSE)
-            return false; 
-    return true; 
+    struct timespec ts; 
+    clock_gettime(CLOCK_MONOTONIC, &ts); 
+    return ts.tv_sec + ts.tv_nsec / 1e9; 
 }
 
-bool is_full(const CHIP board[BOARD_ROWS][BOARD_COLS])
+int column_x(int col)
 {
-    for(int i = 0; i < BOARD_COLS; ++i)
-        if(board[0][i].c == A_REVERSE)
-            return false; 
-    return true; 
+    return OFFSET_X + col * CHIP_WIDTH + col * SEP_WIDTH; 
 }
 
-CHIP *play(CHIP board[BOARD_ROWS][BOARD_COLS])
+// top line of the falling chip, from the row above the board down to its cell
+int fall_y(const GAME *g, double now)
 {
-    int ch = 0; 
+    double t = now - g->start; 
+    int y = OFFSET_Y + (int) (FALL_ACCEL * t * t / 2); 
+    int target = layout[BOARD_ROWS-1 - g->pos.heights[g->col]][g->col].y; 
+    return y < target ? y : target; 
+}
+
+// Marks the empty cells that would complete a line, red ones on the left of
+// the cell and yellow ones on the right, and says what dropping in the
+// cursor's column does.
+void draw_hints(const GAME *g)
+{
+    THREATS t; 
+    threats_analyze(&g->pos, &t); 
+    int h = CHIP_HEIGHT / 2 > 0 ? CHIP_HEIGHT / 2 : 1; 
+    int w = CHIP_WIDTH / 4 > 0 ? CHIP_WIDTH / 4 : 1; 
+    for(int i = 0; i < BOARD_ROWS; ++i)
+        for(int j = 0; j < BOARD_COLS; ++j)
+        {
+            BITBOARD cell = CELL_MASK(BOARD_ROWS-1 - i, j); 
+            int y = layout[i][j].y + (CHIP_HEIGHT - h) / 2; 
+            if(t.wins[0] & cell)
+                draw_rect(player_color(0), h, w, y, layout[i][j].x + CHIP_WIDTH / 2 - w); 
+            if(t.wins[1] & cell)
+                draw_rect(player_color(1), h, w, y, layout[i][j].x + CHIP_WIDTH / 2); 
+        }
 
-    int turn = COLOR_PAIR(RED); 
-    int col = 0; 
-    CHIP *win_chips = NULL; 
+    BITBOARD col = COL_MASK(g->col); 
+    const char *hint; 
+    if(!pos_can_play(&g->pos, g->col)) hint = "full"; 
+    else if(t.immediate & col) hint = "wins"; 
+    else if(t.non_losing & col) hint = t.forced ? "blocks" : "is safe"; 
+    else if(t.forced & col) hint = "blocks, but still loses"; 
+    else if(t.forced) hint = "does not block"; 
+    else hint = "lets the other side win"; 
+
+    char msg[64]; 
+    snprintf(msg, sizeof(msg), "Column %d %s", g->col + 1, hint); 
+    canvas_print(c4_canvas, GAME_LINES - 2, (GAME_COLS - strlen(msg)) / 2, A_NORMAL, msg); 
+}
 
-    // use a do loop to ensure board gets printed at least once
-    do
+// centered on row y of the message window, the whole row reversed if selected
+void draw_message(int y, const char *msg, bool selected)
+{
+    chtype attr = selected ? A_REVERSE : A_NORMAL; 
+    canvas_fill(msg_canvas, y, 0, 1, GAME_COLS, ' ' | attr); 
+    canvas_print(msg_canvas, y, (GAME_COLS - strlen(msg)) / 2, attr, msg); 
+}
+
+void draw_messages(const GAME *g)
+{
+    canvas_clear(msg_canvas); 
+    if(g->state == STATE_OVER)
     {
-        // process input 
-        if(ch == KEY_LEFT && col > 0)
-            --col; 
-        else if(ch == KEY_RIGHT && col < BOARD_COLS-1)
-            ++col; 
-        else if(ch == KEY_DOWN)
-        {
-            int row = get_empty_row(board, col); 
-            if(row >= 0)
-            {
-                board[row][col].c = turn; 
-                turn = turn == COLOR_PAIR(RED) ? COLOR_PAIR(YELLOW) : COLOR_PAIR(RED); 
-                win_chips = get_all_wins(board, row, col); 
-            }
+        // the menu sits halfway down the space under the board
+        int y = (getmaxy(msg_win) - 1) / 2; 
+        draw_message(0, g->result, false); 
+        draw_message(y, "Play Again", g->again); 
+        draw_message(y + 1, "Quit Game", !g->again); 
+    }
+    canvas_flush(msg_canvas); 
+}
 
-        }
+void draw_game(const GAME *g, double now)
+{
+    canvas_clear(c4_canvas); 
+    canvas_box(c4_canvas); 
+    draw_board(&g->pos); 
+    if(server && net_player < 0 && g->state == STATE_PLAY)
+    {
+        const char msg[] = "Waiting for an opponent"; 
+        canvas_print(c4_canvas, GAME_LINES - 2, (GAME_COLS - strlen(msg)) / 2, A_NORMAL, msg); 
+    }
+    else if(g->hints && g->state == STATE_PLAY)
+        draw_hints(g); 
+
+    int color = player_color(pos_player(&g->pos)); 
+    if(g->state == STATE_PLAY)
+        draw_rect(color, CHIP_HEIGHT, CHIP_WIDTH, OFFSET_Y, column_x(g->col)); 
+    else if(g->state == STATE_FALL)
+        draw_rect(color, CHIP_HEIGHT, CHIP_WIDTH, fall_y(g, now), column_x(g->col)); 
+    else if(g->state == STATE_OVER && !g->blink_on)
+    {
+        for(int i = 0; i < BOARD_ROWS; ++i)
+            for(int j = 0; j < BOARD_COLS; ++j)
+                if(g->win_cells & CELL_MASK(BOARD_ROWS-1 - i, j))
+                    erase_chip(i, j); 
+    }
+    canvas_flush(c4_canvas); 
+    draw_messages(g); 
+}
 
-        // draw board 
-        werase(game_win); 
-        box(game_win, 0, 0); 
-        draw_board(board); 
-        draw_rect(turn, CHIP_HEIGHT, CHIP_WIDTH, OFFSET_Y, 
-                OFFSET_X + col * CHIP_WIDTH + col * SEP_WIDTH); 
-        wrefresh(game_win); 
-        
-        // is game finished
-        if(win_chips != NULL || is_full(board)) 
-            break; 
+void drop(GAME *g, int col, double now)
+{
+    g->col = col; 
+    g->state = STATE_FALL; 
+    g->start = now; 
+    g->next = now + FRAME_SECS; 
+}
 
-        // get input for next cycle 
-        if((ch = wgetch(game_win)) == KEY_F(1))
-            cleanup();  
-    }while(true); 
+// the chip reached its cell
+void land(GAME *g, double now)
+{
+    int player = pos_player(&g->pos); 
+    pos_play(&g->pos, g->col); 
+    g->win_cells = pos_win_cells(g->pos.boards[player]); 
+    if(!g->win_cells && !pos_is_full(&g->pos))
+    {
+        g->state = STATE_PLAY; 
+        g->next = 0; 
+        return; 
+    }
 
-    // remove the next chip from play
-    draw_rect(A_NORMAL, CHIP_HEIGHT, CHIP_WIDTH, OFFSET_Y, 
-            OFFSET_X + col * CHIP_WIDTH + col * SEP_WIDTH); 
-    wrefresh(game_win); 
+    g->state = STATE_OVER; 
+    g->blink_on = true; 
+    g->again = true; 
+    g->next = g->win_cells ? now + BLINK_SECS : 0; 
+    if(!g->win_cells) g->result = "It's a tie..."; 
+    else g->result = player == 0 ? "Red wins!!!" : "Yellow wins!!!"; 
+}
 
-    return win_chips; 
+void on_timer(GAME *g, double now)
+{
+    switch(g->state)
+    {
+        case STATE_FALL: 
+            if(fall_y(g, now) == layout[BOARD_ROWS-1 - g->pos.heights[g->col]][g->col].y)
+                land(g, now); 
+            else
+                g->next = now + FRAME_SECS; 
+            break; 
+        case STATE_OVER: 
+            g->blink_on = !g->blink_on; 
+            g->next = now + BLINK_SECS; 
+            break; 
+        case STATE_RESET: 
+            shift_down(&g->pos); 
+            if(is_empty(&g->pos))
+            {
+                pos_init(&g->pos); 
+                g->state = STATE_PLAY; 
+                g->col = 0; 
+                g->next = 0; 
+                if(server) net_join(); 
+            }
+            else
+                g->next = now + RESET_ROW_SECS; 
+            break; 
+        case STATE_PLAY: 
+            g->next = 0; 
+            break; 
+    }
 }
 
-void print_win_msg(int c)
+void on_key(GAME *g, int ch, double now)
 {
-    const char p1_win[] = "Red wins!!!"; 
-    const char p2_win[] = "Yellow wins!!!"; 
-    const char tie[] = "It's a tie..."; 
+    if(ch == KEY_F(1))
+    {
+        g->quit = true; 
+        return; 
+    }
+    if(ch == 'h' || ch == 'H')
+    {
+        g->hints = !g->hints; 
+        return; 
+    }
+    if(ch == 'p' || ch == 'P')
+    {
+        // the next frame puts back what the overlay covered
+        if(!prof_toggle_overlay())
+        {
+            touchwin(stdscr); 
+            wnoutrefresh(stdscr); 
+            canvas_invalidate(c4_canvas); 
+            canvas_invalidate(msg_canvas); 
+        }
+        return; 
+    }
 
-    if(c == COLOR_PAIR(RED))
-        mvprintw(GAME_START_Y + GAME_LINES, 
-                GAME_START_X + (GAME_COLS - strlen(p1_win)) / 2, "%s", p1_win); 
-    else if(c == COLOR_PAIR(YELLOW))
-        mvprintw(GAME_START_Y + GAME_LINES, 
-                GAME_START_X + (GAME_COLS - strlen(p2_win)) / 2, "%s", p2_win); 
-    else 
-        mvprintw(GAME_START_Y + GAME_LINES, 
-                GAME_START_X + (GAME_COLS - strlen(tie)) / 2, "%s", tie); 
+    switch(g->state)
+    {
+        case STATE_PLAY: 
+            if(!human_to_move(g)) break; 
+            if(ch == KEY_LEFT && g->col > 0)
+                --g->col; 
+            else if(ch == KEY_RIGHT && g->col < BOARD_COLS-1)
+                ++g->col; 
+            else if(ch == KEY_DOWN && pos_can_play(&g->pos, g->col))
+            {
+                // the search winds down while the chip falls
+                cancel_ponder(); 
+                if(server)
+                {
+                    client_send(server, MSG_MOVE, g->col, net_game); 
+                    client_flush(server); 
+                }
+                drop(g, g->col, now); 
+            }
+            break; 
+        case STATE_OVER: 
+            if(ch == KEY_DOWN || ch == KEY_UP)
+                g->again = ch == KEY_UP; 
+            else if(ch == 10 && !g->again)
+                g->quit = true; 
+            else if(ch == 10)
+            {
+                g->state = STATE_RESET; 
+                g->next = now + RESET_ROW_SECS; 
+            }
+            break; 
+        default: 
+            if(g->npending < MAX_PENDING)
+                g->pending[g->npending++] = ch; 
+            break; 
+    }
 }
 
-bool play_again()
+// replays the keys typed while the last animation ran
+void flush_pending(GAME *g, double now)
 {
-    const char replay[] = "Play Again"; 
-    const char quit[] = "Quit Game";  
+    int n = g->npending; 
+    int keys[MAX_PENDING]; 
+    memcpy(keys, g->pending, n * sizeof(int)); 
+    g->npending = 0; 
+    for(int i = 0; i < n; ++i)
+        on_key(g, keys[i], now); 
+}
 
-    int ch = 0; 
-    int y = GAME_START_Y + GAME_LINES; 
-    y += (LINES - (GAME_START_Y + GAME_LINES + 1)) / 2; 
-    bool again = true; 
-    do
+// Keys and animation timers are multiplexed here. wgetch waits until the next 
+// timer is due, so input is never blocked by an animation and nothing else 
+// touches curses. 
+int connect4_tick()
+{
+    GAME *g = &game; 
+    double now = get_time(); 
+    if(g->state == STATE_PLAY && g->npending)
+        PROF_SCOPE(PROF_INPUT) flush_pending(g, now); 
+    else if(g->state == STATE_PLAY && pos_player(&g->pos) == ai_player)
+    {
+        // the board it thinks about is on screen since the last frame
+        PROF_SCOPE(PROF_SIM)
+        {
+            stop_ponder(); 
+            drop(g, ai_move(&g->pos, pondered(&g->pos, g->col)), get_time()); 
+        }
+    }
+    else if(g->state == STATE_PLAY && net_move >= 0 && pos_player(&g->pos) == net_player)
+    {
+        drop(g, net_move, now); 
+        net_move = -1; 
+    }
+    else
     {
-        // handle input
-        if(ch == KEY_DOWN && again)         again = false; 
-        else if(ch == KEY_UP && !again)     again = true; 
-        else if(ch == KEY_F(1))             cleanup(); 
-
-        // print options
-        mvprintw(y, GAME_START_X + (GAME_COLS - strlen(replay)) / 2, "%s", replay); 
-        mvprintw(y+1, GAME_START_X + (GAME_COLS - strlen(quit)) / 2, "%s", quit); 
-        if(again)
+        if(g->state == STATE_PLAY)
+            start_ponder(&g->pos); 
+
+        int wait = -1; 
+        if(g->next)
         {
-            mvchgat(y, GAME_START_X, GAME_COLS, A_REVERSE, 0, NULL);  
-            mvchgat(y+1, GAME_START_X, GAME_COLS, A_NORMAL, 0, NULL); 
+            wait = (int) ((g->next - now) * 1000 + 0.5); 
+            if(wait < 0) wait = 0; 
         }
+        int ch; 
+        if(server)
+            ch = net_wait(g, wait); 
         else
         {
-            mvchgat(y, GAME_START_X, GAME_COLS, A_NORMAL, 0, NULL);  
-            mvchgat(y+1, GAME_START_X, GAME_COLS, A_REVERSE, 0, NULL); 
+            wtimeout(c4_win, wait); 
+            ch = wgetch(c4_win); 
         }
-    }while((ch = getch()) != 10); 
-    
-    // delete options 
-    move(y, 0); 
-    clrtoeol(); 
-    move(y+1, 0); 
-    clrtoeol();
 
-    return again; 
+        now = get_time(); 
+        if(ch != ERR)
+            PROF_SCOPE(PROF_INPUT) on_key(g, ch, now); 
+        if(g->next && now >= g->next)
+            PROF_SCOPE(PROF_SIM) on_timer(g, now); 
+    }
+
+    if(!g->quit) return 1; 
+    stop_ponder(); 
+    return 0; 
 }
 
-void shift_down(CHIP board[BOARD_ROWS][BOARD_COLS], int beg)
+int connect4_render()
 {
-    int down[BOARD_ROWS][BOARD_COLS];
-    for(int i = 0; i < BOARD_ROWS; ++i)
-        for(int j = 0; j < BOARD_COLS; ++j)
-            down[i][j] = i > beg ? board[i-1][j].c : A_REVERSE;  
-    
-    for(int i = 0; i < BOARD_ROWS; ++i)
-        for(int j = 0; j < BOARD_COLS; ++j)
-            board[i][j].c = down[i][j]; 
+    draw_game(&game, get_time()); 
+    term_frame(); 
+    return 1; 
 }
 
-void reset(CHIP board[BOARD_ROWS][BOARD_COLS]) 
+// drops every stone one row, the bottom row falls off the board
+void shift_down(POSITION *pos)
 {
-    for(int i = 0; i < BOARD_ROWS && !is_empty(board); ++i)
+    for(int p = 0; p < 2; ++p)
+        pos->boards[p] = (pos->boards[p] >> 1) & BOARD_MASK; 
+    pos->moves = 0; 
+    for(int c = 0; c < BOARD_COLS; ++c)
     {
-        draw_board(board); 
-        wrefresh(game_win); 
-        shift_down(board, i); 
-        sleep(1); 
+        if(pos->heights[c] > 0) --pos->heights[c]; 
+        pos->moves += pos->heights[c]; 
     }
-    draw_board(board); 
-    wrefresh(game_win); 
 }
 
-void *blink(void *pargs)
+bool is_empty(const POSITION *pos)
 {
-    CHIP *chips = (CHIP *) pargs; 
-    while(true)
-    {
-        for(int i = 0; i < 4; ++i)
-            draw_chip(chips[i]); 
-        wrefresh(game_win); 
-        sleep(1); 
-        for(int i = 0; i < 4; ++i)
-            erase_chip(chips[i]); 
-        wrefresh(game_win); 
-        sleep(1); 
-    }
+    return !(pos->boards[0] | pos->boards[1]); 
 }
 
-void cleanup()
+void connect4_shutdown()
 {
-    delwin(game_win); 
-    endwin(); 
-    exit(0); 
+    stop_ponder(); 
+    book_close(book); 
+    cache_close(cache); 
+    client_close(server); 
+    canvas_destroy(c4_canvas); 
+    delwin(c4_win); 
+    canvas_destroy(msg_canvas); 
+    delwin(msg_win); 
 }
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "book.h"
+#include "solver.h"
+
+// Every position from the start up to the book's ply, one level per ply.
+// Only the deepest level is searched, shallower scores are backed up from the
+// level below, which holds every position they lead to.
+typedef struct NODE
+{
+    BITBOARD key; 
+    POSITION pos; 
+    int score; 
+}NODE; 
+
+typedef struct LEVEL
+{
+    NODE *nodes; 
+    size_t count; 
+}LEVEL; 
+
+int compare_nodes(const void *a, const void *b)
+{
+    BITBOARD x = ((const NODE *) a)->key, y = ((const NODE *) b)->key; 
+    return x < y ? -1 : x > y; 
+}
+
+int compare_entries(const void *a, const void *b)
+{
+    BOOK_ENTRY x = *(const BOOK_ENTRY *) a, y = *(const BOOK_ENTRY *) b; 
+    return x < y ? -1 : x > y; 
+}
+
+// sorts by key and drops repeats, mirror images share a key
+void unique(LEVEL *level)
+{
+    qsort(level->nodes, level->count, sizeof(NODE), compare_nodes); 
+    size_t n = 0; 
+    for(size_t i = 0; i < level->count; ++i)
+        if(n == 0 || level->nodes[i].key != level->nodes[n-1].key)
+            level->nodes[n++] = level->nodes[i]; 
+    level->count = n; 
+}
+
+// every position one stone deeper that is not already won
+void expand(const LEVEL *from, LEVEL *to)
+{
+    to->nodes = (NODE *) malloc((from->count * BOARD_COLS + 1) * sizeof(NODE)); 
+    to->count = 0; 
+    for(size_t i = 0; i < from->count; ++i)
+    {
+        POSITION pos = from->nodes[i].pos; 
+        int me = pos_player(&pos); 
+        for(int c = 0; c < BOARD_COLS; ++c)
+        {
+            if(!pos_can_play(&pos, c) || pos_is_win(pos.boards[me] | CELL_MASK(pos.heights[c], c)))
+                continue; 
+            pos_play(&pos, c); 
+            NODE *node = &to->nodes[to->count++]; 
+            node->key = book_key(&pos); 
+            node->pos = pos; 
+            pos_undo(&pos, c); 
+        }
+    }
+    unique(to); 
+}
+
+const NODE *find(const LEVEL *level, BITBOARD key)
+{
+    NODE target = { .key = key }; 
+    return (const NODE *) bsearch(&target, level->nodes, level->count, sizeof(NODE), compare_nodes); 
+}
+
+// negamax over one ply with the children already scored
+int back_up(const LEVEL *below, POSITION pos)
+{
+    int me = pos_player(&pos); 
+    if(pos_is_full(&pos)) return 0; 
+
+    int best = -SCORE_INF; 
+    for(int c = 0; c < BOARD_COLS; ++c)
+    {
+        if(!pos_can_play(&pos, c)) continue; 
+        if(pos_is_win(pos.boards[me] | CELL_MASK(pos.heights[c], c)))
+            return SCORE_WIN - (pos.moves + 1); 
+
+        pos_play(&pos, c); 
+        int score = -find(below, book_key(&pos))->score; 
+        pos_undo(&pos, c); 
+        if(score > best) best = score; 
+    }
+    return best; 
+}
+
+int main(int argc, char **argv)
+{
+    int ply = 8, threads = 1; 
+    const char *start = "", *path = BOOK_FILE; 
+    int opt; 
+    while((opt = getopt(argc, argv, "p:s:j:o:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'p': ply = atoi(optarg); break; 
+            case 's': start = optarg; break; 
+            case 'j': threads = atoi(optarg); break; 
+            case 'o': path = optarg; break; 
+            default:
+                fprintf(stderr, "usage: %s [-p ply] [-s moves] [-j threads] [-o file]\n", argv[0]); 
+                fprintf(stderr, "  -p ply     deepest position in the book\n"); 
+                fprintf(stderr, "  -s moves   only positions after these moves, such as 4453\n"); 
+                fprintf(stderr, "  -j n       search threads\n"); 
+                fprintf(stderr, "  -o file    output, default %s\n", BOOK_FILE); 
+                return 1; 
+        }
+    }
+
+    if(!BOOK_SUPPORTED)
+    {
+        fprintf(stderr, "books need keys of at most 56 bits, this board has %d\n", KEY_BITS); 
+        return 1; 
+    }
+
+    POSITION root; 
+    if(pos_from_moves(&root, start) != (int) strlen(start))
+    {
+        fprintf(stderr, "%s: not a playable line\n", start); 
+        return 1; 
+    }
+    if(ply < root.moves || ply > BOARD_ROWS * BOARD_COLS)
+    {
+        fprintf(stderr, "ply must be between %d and %d\n", root.moves, BOARD_ROWS * BOARD_COLS); 
+        return 1; 
+    }
+
+    // levels[i] holds the positions with root.moves + i stones
+    int depth = ply - root.moves; 
+    LEVEL *levels = (LEVEL *) calloc(depth + 1, sizeof(LEVEL)); 
+    levels[0].nodes = (NODE *) malloc(sizeof(NODE)); 
+    levels[0].nodes[0].key = book_key(&root); 
+    levels[0].nodes[0].pos = root; 
+    levels[0].count = 1; 
+    size_t total = 1; 
+    for(int i = 1; i <= depth; ++i)
+    {
+        expand(&levels[i-1], &levels[i]); 
+        total += levels[i].count; 
+        fprintf(stderr, "ply %d: %zu positions\n", root.moves + i, levels[i].count); 
+    }
+
+    // the table is kept between searches, neighbouring positions share a lot
+    TTABLE *tt = tt_create(DEFAULT_TT_ENTRIES); 
+    LEVEL *deepest = &levels[depth]; 
+    double secs = 0; 
+    for(size_t i = 0; i < deepest->count; ++i)
+    {
+        SEARCH_RESULT result; 
+        deepest->nodes[i].score = solve(&deepest->nodes[i].pos, tt, threads, &result); 
+        secs += result.secs; 
+        if((i + 1) % 256 == 0 || i + 1 == deepest->count)
+            fprintf(stderr, "\rsolved %zu/%zu, %.1f s", i + 1, deepest->count, secs); 
+    }
+    fprintf(stderr, "\n"); 
+    tt_destroy(tt); 
+
+    for(int i = depth - 1; i >= 0; --i)
+        for(size_t j = 0; j < levels[i].count; ++j)
+            levels[i].nodes[j].score = back_up(&levels[i+1], levels[i].nodes[j].pos); 
+
+    BOOK_ENTRY *entries = (BOOK_ENTRY *) malloc(total * sizeof(BOOK_ENTRY)); 
+    size_t n = 0; 
+    for(int i = 0; i <= depth; ++i)
+    {
+        for(size_t j = 0; j < levels[i].count; ++j)
+            entries[n++] = BOOK_ENTRY_MAKE(levels[i].nodes[j].key, book_pack_score(levels[i].nodes[j].score)); 
+        free(levels[i].nodes); 
+    }
+    free(levels); 
+    qsort(entries, n, sizeof(BOOK_ENTRY), compare_entries); 
+
+    BOOK_HEADER header = { BOOK_MAGIC, BOARD_ROWS, BOARD_COLS, ply, WIN_LENGTH, n }; 
+    FILE *f = fopen(path, "wb"); 
+    if(!f || fwrite(&header, sizeof(header), 1, f) != 1 || fwrite(entries, sizeof(BOOK_ENTRY), n, f) != n)
+    {
+        perror(path); 
+        return 1; 
+    }
+    fclose(f); 
+    free(entries); 
+
+    printf("%s: %zu positions up to ply %d, %zu bytes\n", path, n, ply, 
+        sizeof(BOOK_HEADER) + n * sizeof(BOOK_ENTRY)); 
+    return 0; 
+}
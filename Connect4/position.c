@@ -0,0 +1,38 @@
+#include <string.h>
+
+#include "position.h"
+
+void pos_init(POSITION *pos)
+{
+    memset(pos, 0, sizeof(POSITION)); 
+}
+
+// 0 or 1 for a stone of that player, -1 if empty, row 0 is the bottom
+int pos_at(const POSITION *pos, int r, int c)
+{
+    if(pos->boards[0] & CELL_MASK(r, c)) return 0; 
+    if(pos->boards[1] & CELL_MASK(r, c)) return 1; 
+    return -1; 
+}
+
+bool pos_is_full(const POSITION *pos)
+{
+    return pos->moves == BOARD_ROWS * BOARD_COLS; 
+}
+
+// plays a string of 1-based columns such as "4453", stops before a bad or 
+// winning move and returns how many were played
+int pos_from_moves(POSITION *pos, const char *moves)
+{
+    pos_init(pos); 
+    int n = 0; 
+    for(; moves[n]; ++n)
+    {
+        int c = moves[n] - '1'; 
+        if(c < 0 || c >= BOARD_COLS || !pos_can_play(pos, c)) break; 
+        BITBOARD after = pos->boards[pos_player(pos)] | CELL_MASK(pos->heights[c], c); 
+        if(pos_is_win(after)) break; 
+        pos_play(pos, c); 
+    }
+    return n; 
+}
@@ -0,0 +1,159 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Connect-K on any board up to 128 cells plus one spare row, for example 
+// cc -DBOARD_ROWS=8 -DBOARD_COLS=9 -DWIN_LENGTH=5. Sizes are fixed at compile 
+// time so every shift and mask below folds to a constant. 
+#ifndef BOARD_ROWS
+#define BOARD_ROWS 6
+#endif
+#ifndef BOARD_COLS
+#define BOARD_COLS 7
+#endif
+#ifndef WIN_LENGTH
+#define WIN_LENGTH 4
+#endif
+
+// names files that only one variant can read, such as connect4_6x7
+#define STR(x) #x
+#define XSTR(x) STR(x)
+#define VARIANT_NAME "connect" XSTR(WIN_LENGTH) "_" XSTR(BOARD_ROWS) "x" XSTR(BOARD_COLS)
+
+#define COL_BITS (BOARD_ROWS + 1)
+#define KEY_BITS (BOARD_COLS * COL_BITS)
+
+// Bitboards are column major, bit c * (BOARD_ROWS + 1) + r is row r (from the 
+// bottom) of column c. The extra bit on top of every column is always empty so 
+// lines cannot wrap from one column into the next. Boards that do not fit in 
+// 64 bits use the 128 bit integers of gcc and clang. 
+#if KEY_BITS <= 64
+typedef uint64_t BITBOARD; 
+#define BITBOARD_BITS 64
+#elif KEY_BITS <= 128
+typedef unsigned __int128 BITBOARD; 
+#define BITBOARD_BITS 128
+#else
+#error "the board needs more than 128 bits, (BOARD_ROWS + 1) * BOARD_COLS is too big"
+#endif
+
+#if WIN_LENGTH < 2 || (WIN_LENGTH > BOARD_ROWS && WIN_LENGTH > BOARD_COLS)
+#error "WIN_LENGTH does not fit on the board"
+#endif
+#if (WIN_LENGTH - 1) * (COL_BITS + 1) >= BITBOARD_BITS
+#error "lines of WIN_LENGTH shift past the end of the bitboard"
+#endif
+
+#define BOTTOM_MASK(c) ((BITBOARD) 1 << (c) * COL_BITS)
+#define TOP_MASK(c) ((BITBOARD) 1 << ((c) * COL_BITS + BOARD_ROWS - 1))
+#define COL_MASK(c) ((((BITBOARD) 1 << BOARD_ROWS) - 1) << (c) * COL_BITS)
+#define CELL_MASK(r, c) ((BITBOARD) 1 << ((c) * COL_BITS + (r)))
+
+// bottom cell of every column and every playable cell
+#define ALL_BITS (~(BITBOARD) 0 >> (BITBOARD_BITS - KEY_BITS))
+#define BOTTOM_ROW (ALL_BITS / (((BITBOARD) 1 << COL_BITS) - 1))
+#define BOARD_MASK (BOTTOM_ROW * (((BITBOARD) 1 << BOARD_ROWS) - 1))
+
+typedef struct POSITION
+{
+    BITBOARD boards[2];         // stones of the first (red) and second (yellow) player 
+    int heights[BOARD_COLS]; 
+    int moves; 
+}POSITION; 
+
+void pos_init(POSITION *pos); 
+int pos_at(const POSITION *pos, int r, int c); 
+bool pos_is_full(const POSITION *pos); 
+int pos_from_moves(POSITION *pos, const char *moves); 
+
+// player to move, 0 is red
+static inline int pos_player(const POSITION *pos)
+{
+    return pos->moves & 1; 
+}
+
+static inline bool pos_can_play(const POSITION *pos, int c)
+{
+    return pos->heights[c] < BOARD_ROWS; 
+}
+
+static inline void pos_play(POSITION *pos, int c)
+{
+    pos->boards[pos->moves & 1] |= CELL_MASK(pos->heights[c], c); 
+    ++pos->heights[c]; 
+    ++pos->moves; 
+}
+
+static inline void pos_undo(POSITION *pos, int c)
+{
+    --pos->moves; 
+    --pos->heights[c]; 
+    pos->boards[pos->moves & 1] &= ~CELL_MASK(pos->heights[c], c); 
+}
+
+static inline int pos_popcount(BITBOARD b)
+{
+#if BITBOARD_BITS == 64
+    return __builtin_popcountll(b); 
+#else
+    return __builtin_popcountll((uint64_t) b) + __builtin_popcountll((uint64_t) (b >> 64)); 
+#endif
+}
+
+// stones that start WIN_LENGTH in a row along direction s, doubling the run 
+// each step so four in a row takes two shifts and ANDs
+static inline BITBOARD pos_runs(BITBOARD b, int s)
+{
+    BITBOARD m = b; 
+    int len = 1; 
+    for(; len * 2 <= WIN_LENGTH; len *= 2)
+        m &= m >> len * s; 
+    if(len < WIN_LENGTH)
+        m &= m >> (WIN_LENGTH - len) * s; 
+    return m; 
+}
+
+// WIN_LENGTH in a row along any of the directions
+static inline bool pos_is_win(BITBOARD b)
+{
+    static const int shifts[4] = { 1, COL_BITS, COL_BITS - 1, COL_BITS + 1 }; 
+    for(int i = 0; i < 4; ++i)
+        if(pos_runs(b, shifts[i])) 
+            return true; 
+    return false; 
+}
+
+// unique per position, the stones of the player to move plus one bit above 
+// the top stone of every column
+static inline BITBOARD pos_key(const POSITION *pos)
+{
+    BITBOARD mask = pos->boards[0] | pos->boards[1]; 
+    return pos->boards[pos_player(pos)] + mask; 
+}
+
+// the board flipped left to right, works on keys as well as stones
+static inline BITBOARD pos_mirror(BITBOARD b)
+{
+    BITBOARD m = 0; 
+    for(int c = 0; c < BOARD_COLS; ++c)
+        m |= ((b >> c * COL_BITS) & (((BITBOARD) 1 << COL_BITS) - 1)) << (BOARD_COLS-1 - c) * COL_BITS; 
+    return m; 
+}
+
+// every stone that belongs to WIN_LENGTH in a row
+static inline BITBOARD pos_win_cells(BITBOARD b)
+{
+    static const int shifts[4] = { 1, COL_BITS, COL_BITS - 1, COL_BITS + 1 }; 
+    BITBOARD cells = 0; 
+    for(int i = 0; i < 4; ++i)
+    {
+        BITBOARD starts = pos_runs(b, shifts[i]); 
+        for(int k = 0; k < WIN_LENGTH; ++k)
+            cells |= starts << k * shifts[i]; 
+    }
+    return cells; 
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "position.h"
+#include "threats.h"
+
+// Headless checks for the bitboard position, exits non-zero on failure. 
+
+// plays moves without stopping at wins and returns the last mover
+int play_all(POSITION *pos, const char *moves)
+{
+    pos_init(pos); 
+    for(; *moves; ++moves)
+        pos_play(pos, *moves - '1'); 
+    return pos_player(pos) ^ 1; 
+}
+
+void test_wins()
+{
+    const struct { const char *moves; bool win; int cells; } cases[] = {
+        { "1212121", true, 4 },         // vertical
+        { "1122334", true, 4 },         // horizontal
+        { "122334344", false, 0 },      // diagonal missing its top
+        { "1223343445474", true, 4 },   // rising diagonal
+        { "7665545443414", true, 4 },   // falling diagonal
+        { "1111112222223", false, 0 },  // columns do not wrap into each other
+        { "12121213", false, 0 }, 
+        { "1122334455", true, 5 },      // five in a row
+    }; 
+    for(int i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); ++i)
+    {
+        POSITION pos; 
+        int player = play_all(&pos, cases[i].moves); 
+        BITBOARD b = pos.boards[player]; 
+        CHECK(pos_is_win(b) == cases[i].win, "%s", cases[i].moves); 
+        CHECK(__builtin_popcountll(pos_win_cells(b)) == cases[i].cells, "%s", cases[i].moves); 
+    }
+}
+
+void test_play_undo()
+{
+    POSITION pos, copy; 
+    play_all(&pos, "4453362"); 
+    copy = pos; 
+    for(int c = 0; c < BOARD_COLS; ++c)
+    {
+        pos_play(&pos, c); 
+        CHECK(pos_at(&pos, pos.heights[c] - 1, c) == pos_player(&copy), "column %d", c); 
+        pos_undo(&pos, c); 
+        CHECK(!memcmp(&pos, &copy, sizeof(POSITION)), "column %d", c); 
+    }
+
+    CHECK(pos_from_moves(&pos, "1212121") == 6, "stops before the win"); 
+    CHECK(pos_from_moves(&pos, "11111111") == 6, "stops at a full column"); 
+    CHECK(pos_from_moves(&pos, "4453") == 4 && pos.moves == 4, "plays every move"); 
+    CHECK(pos_at(&pos, 0, 3) == 0 && pos_at(&pos, 1, 3) == 1 && pos_at(&pos, 2, 3) == -1, "stacking"); 
+}
+
+void test_masks()
+{
+    CHECK(__builtin_popcountll(BOARD_MASK) == BOARD_ROWS * BOARD_COLS, "board mask"); 
+    CHECK(__builtin_popcountll(BOTTOM_ROW) == BOARD_COLS, "bottom row"); 
+    for(int c = 0; c < BOARD_COLS; ++c)
+        CHECK((BOARD_MASK & COL_MASK(c)) == COL_MASK(c), "column %d", c); 
+}
+
+// playable cells the opponent would win on after playing in c
+BITBOARD wins_after(POSITION *pos, int c)
+{
+    int me = pos_player(pos); 
+    pos_play(pos, c); 
+    BITBOARD r = 0; 
+    for(int d = 0; d < BOARD_COLS; ++d)
+        if(pos_can_play(pos, d) && pos_is_win(pos->boards[me ^ 1] | CELL_MASK(pos->heights[d], d)))
+            r |= CELL_MASK(pos->heights[d], d); 
+    pos_undo(pos, c); 
+    return r; 
+}
+
+// threats against the slow way, placing a stone on every empty cell
+void test_threats()
+{
+    const char *lines[] = {
+        "12131", 
+        "121314", 
+        "445566", 
+        "476553644766", 
+        "325414526443", 
+        "5257316472461347264465", 
+        "7337741471564565523351", 
+        "57344465377613765664622155", 
+    }; 
+    for(int i = 0; i < (int)(sizeof(lines) / sizeof(lines[0])); ++i)
+    {
+        POSITION pos; 
+        CHECK(pos_from_moves(&pos, lines[i]) == (int) strlen(lines[i]), "%s", lines[i]); 
+        THREATS t; 
+        threats_analyze(&pos, &t); 
+
+        BITBOARD mask = pos.boards[0] | pos.boards[1]; 
+        for(int p = 0; p < 2; ++p)
+        {
+            BITBOARD wins = 0; 
+            for(int c = 0; c < BOARD_COLS; ++c)
+                for(int r = 0; r < BOARD_ROWS; ++r)
+                    if(!(mask & CELL_MASK(r, c)) && pos_is_win(pos.boards[p] | CELL_MASK(r, c)))
+                        wins |= CELL_MASK(r, c); 
+            CHECK(t.wins[p] == wins, "%s player %d", lines[i], p); 
+        }
+
+        int me = pos_player(&pos); 
+        for(int c = 0; c < BOARD_COLS; ++c)
+        {
+            if(!pos_can_play(&pos, c)) continue; 
+            BITBOARD cell = CELL_MASK(pos.heights[c], c); 
+            CHECK(((t.immediate & cell) != 0) == pos_is_win(pos.boards[me] | cell), "%s column %d", lines[i], c); 
+            CHECK(((t.non_losing & cell) != 0) == (wins_after(&pos, c) == 0), "%s column %d", lines[i], c); 
+        }
+    }
+
+    POSITION pos; 
+    THREATS t; 
+    pos_from_moves(&pos, "12131"); 
+    threats_analyze(&pos, &t); 
+    CHECK(t.forced == CELL_MASK(3, 0) && t.non_losing == t.forced, "one cell to block"); 
+    pos_from_moves(&pos, "44556"); 
+    threats_analyze(&pos, &t); 
+    CHECK(pos_popcount(t.forced) == 2 && t.non_losing == 0, "two cells to block"); 
+}
+
+int main()
+{
+    test_wins(); 
+    test_play_undo(); 
+    test_masks(); 
+    test_threats(); 
+
+    return check_report(); 
+}
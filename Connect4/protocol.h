@@ -0,0 +1,54 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+
+#define SOCKET_FILE "connect4.sock"
+
+// Every message is 8 bytes in the byte order of the host, both ends are on
+// the same machine. A connection can play any number of games at once, game
+// says which one a message is about.
+typedef struct MESSAGE
+{
+    uint8_t type; 
+    uint8_t arg; 
+    uint16_t pad; 
+    uint32_t game; 
+}MESSAGE; 
+
+enum
+{
+    // client to server
+    MSG_JOIN = 1,       // arg is the color wanted, JOIN_RED, JOIN_YELLOW or JOIN_ANY
+    MSG_MOVE,           // arg is the column, also sent to the opponent
+    MSG_RESIGN, 
+
+    // server to client
+    MSG_START,          // arg is the color to play, 0 for red, game is the new game
+    MSG_END,            // arg is the result for the receiver, END_WIN ...
+    MSG_ERROR,          // arg is the problem with the last message about game
+}; 
+
+enum
+{
+    JOIN_RED, 
+    JOIN_YELLOW, 
+    JOIN_ANY, 
+}; 
+
+enum
+{
+    END_WIN, 
+    END_LOSS, 
+    END_DRAW, 
+    END_LEFT,           // the opponent resigned, played an illegal move or disconnected
+}; 
+
+enum
+{
+    ERROR_TYPE = 1,     // unknown message
+    ERROR_GAME,         // not a game of this connection
+    ERROR_TURN,         // not the sender's turn
+}; 
+
+#endif
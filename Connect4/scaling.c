@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "solver.h"
+
+// midgame positions that take the single threaded solver a fraction of a
+// second up to a couple of seconds each
+const char *positions[] =
+{
+    "47577445522754", 
+    "25174345725263", 
+    "72531157141734", 
+    "65721432157661", 
+    "5762155623156151", 
+    "3511542762441617", 
+}; 
+
+#define POSITION_COUNT (int) (sizeof(positions) / sizeof(positions[0]))
+
+typedef struct RUN
+{
+    double secs; 
+    unsigned long long nodes; 
+    int scores[POSITION_COUNT]; 
+}RUN; 
+
+// solves every position from an empty table
+void run(TTABLE *tt, int threads, RUN *r)
+{
+    r->secs = 0; 
+    r->nodes = 0; 
+    for(int i = 0; i < POSITION_COUNT; ++i)
+    {
+        POSITION pos; 
+        pos_from_moves(&pos, positions[i]); 
+        tt_clear(tt); 
+
+        SEARCH_RESULT result; 
+        r->scores[i] = solve(&pos, tt, threads, &result); 
+        r->secs += result.secs; 
+        r->nodes += result.nodes; 
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int max_threads = (int) sysconf(_SC_NPROCESSORS_ONLN); 
+    int opt; 
+    while((opt = getopt(argc, argv, "j:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'j': max_threads = atoi(optarg); break; 
+            default:
+                fprintf(stderr, "usage: %s [-j max threads]\n", argv[0]); 
+                return 1; 
+        }
+    }
+    if(max_threads < 1) max_threads = 1; 
+
+    TTABLE *tt = tt_create(DEFAULT_TT_ENTRIES); 
+    RUN base; 
+    bool ok = true; 
+
+    printf("%d positions, %d cpus\n", POSITION_COUNT, (int) sysconf(_SC_NPROCESSORS_ONLN)); 
+    printf("%8s %10s %14s %12s %8s\n", "threads", "time (s)", "nodes", "nodes/s", "speedup"); 
+    for(int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        RUN r; 
+        run(tt, threads, &r); 
+        if(threads == 1) base = r; 
+
+        // every thread count has to agree on the proven scores
+        for(int i = 0; i < POSITION_COUNT; ++i)
+        {
+            if(r.scores[i] != base.scores[i])
+            {
+                printf("%s: %d threads scored %d, 1 thread %d\n", 
+                    positions[i], threads, r.scores[i], base.scores[i]); 
+                ok = false; 
+            }
+        }
+
+        printf("%8d %10.3f %14llu %12.0f %7.2fx\n", threads, r.secs, r.nodes, 
+            r.nodes / r.secs, base.secs / r.secs); 
+    }
+
+    tt_destroy(tt); 
+    return ok ? 0 : 1; 
+}
@@ -0,0 +1,417 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "position.h"
+#include "protocol.h"
+
+// Headless match server. One thread waits on every connection with epoll,
+// handles all the messages that came in and then writes every reply, so a
+// busy connection gets one read and one write per round however many games
+// it plays.
+
+#define MAX_EVENTS 256
+#define IN_SIZE 16384
+
+typedef struct PEER
+{
+    int fd; 
+    uint8_t in[IN_SIZE]; 
+    size_t in_len; 
+    uint8_t *out; 
+    size_t out_len, out_cap; 
+    bool dirty;         // has replies to write this round
+    bool closed;        // freed at the end of the round
+}PEER; 
+
+typedef struct MATCH
+{
+    POSITION pos; 
+    PEER *players[2];   // both NULL when the slot is free
+}MATCH; 
+
+typedef struct WAITING
+{
+    PEER *peer; 
+    int color; 
+}WAITING; 
+
+int epoll_fd; 
+volatile sig_atomic_t quit; 
+
+MATCH *matches; 
+int match_count, match_cap; 
+uint32_t *free_ids; 
+int free_count, free_cap; 
+
+WAITING *waiting; 
+int waiting_count, waiting_cap; 
+
+// peers with replies or to close, handled once every message is read
+PEER **touched; 
+int touched_count, touched_cap; 
+
+int peer_count; 
+unsigned long finished; 
+
+#define GROW(array, count, cap) \
+    do { \
+        if((count) == (cap)) \
+        { \
+            (cap) = (cap) ? (cap) * 2 : 64; \
+            (array) = realloc((array), (cap) * sizeof(*(array))); \
+        } \
+    } while(0)
+
+void touch(PEER *p)
+{
+    if(p->dirty) return; 
+    p->dirty = true; 
+    GROW(touched, touched_count, touched_cap); 
+    touched[touched_count++] = p; 
+}
+
+void send_msg(PEER *p, int type, int arg, uint32_t game)
+{
+    if(p->closed) return; 
+    if(p->out_len + sizeof(MESSAGE) > p->out_cap)
+    {
+        p->out_cap = p->out_cap ? p->out_cap * 2 : 1024; 
+        p->out = (uint8_t *) realloc(p->out, p->out_cap); 
+    }
+    MESSAGE msg = { (uint8_t) type, (uint8_t) arg, 0, game }; 
+    memcpy(p->out + p->out_len, &msg, sizeof(msg)); 
+    p->out_len += sizeof(msg); 
+    touch(p); 
+}
+
+void end_match(uint32_t id, int winner, int result)
+{
+    MATCH *m = &matches[id]; 
+    if(winner < 0)
+    {
+        send_msg(m->players[0], MSG_END, END_DRAW, id); 
+        send_msg(m->players[1], MSG_END, END_DRAW, id); 
+    }
+    else
+    {
+        send_msg(m->players[winner], MSG_END, result, id); 
+        send_msg(m->players[winner ^ 1], MSG_END, END_LOSS, id); 
+    }
+    m->players[0] = m->players[1] = NULL; 
+    GROW(free_ids, free_count, free_cap); 
+    free_ids[free_count++] = id; 
+    ++finished; 
+}
+
+void start_match(PEER *red, PEER *yellow)
+{
+    uint32_t id; 
+    if(free_count)
+        id = free_ids[--free_count]; 
+    else
+    {
+        GROW(matches, match_count, match_cap); 
+        id = match_count++; 
+    }
+    MATCH *m = &matches[id]; 
+    pos_init(&m->pos); 
+    m->players[0] = red; 
+    m->players[1] = yellow; 
+    send_msg(red, MSG_START, 0, id); 
+    send_msg(yellow, MSG_START, 1, id); 
+}
+
+// pairs with the first compatible player that is waiting, never with itself
+void join(PEER *p, int color)
+{
+    for(int i = 0; i < waiting_count; ++i)
+    {
+        WAITING w = waiting[i]; 
+        if(w.peer == p || (w.color != JOIN_ANY && w.color == color)) continue; 
+
+        memmove(&waiting[i], &waiting[i+1], (waiting_count - i - 1) * sizeof(WAITING)); 
+        --waiting_count; 
+        bool p_red = color == JOIN_RED || w.color == JOIN_YELLOW; 
+        if(p_red) start_match(p, w.peer); 
+        else start_match(w.peer, p); 
+        return; 
+    }
+    GROW(waiting, waiting_count, waiting_cap); 
+    waiting[waiting_count].peer = p; 
+    waiting[waiting_count++].color = color; 
+}
+
+// the player p is in the game, -1 if the game is not one of its own
+int side(PEER *p, uint32_t id)
+{
+    if(id >= (uint32_t) match_count) return -1; 
+    if(matches[id].players[0] == p) return 0; 
+    if(matches[id].players[1] == p) return 1; 
+    return -1; 
+}
+
+void move(PEER *p, uint32_t id, int col)
+{
+    int me = side(p, id); 
+    if(me < 0)
+    {
+        send_msg(p, MSG_ERROR, ERROR_GAME, id); 
+        return; 
+    }
+    MATCH *m = &matches[id]; 
+    if(pos_player(&m->pos) != me)
+    {
+        send_msg(p, MSG_ERROR, ERROR_TURN, id); 
+        return; 
+    }
+    // an illegal move loses, the game could not go on otherwise
+    if(col >= BOARD_COLS || !pos_can_play(&m->pos, col))
+    {
+        end_match(id, me ^ 1, END_LEFT); 
+        return; 
+    }
+
+    pos_play(&m->pos, col); 
+    send_msg(m->players[me ^ 1], MSG_MOVE, col, id); 
+    if(pos_is_win(m->pos.boards[me]))
+        end_match(id, me, END_WIN); 
+    else if(pos_is_full(&m->pos))
+        end_match(id, -1, END_DRAW); 
+}
+
+void handle(PEER *p, const MESSAGE *msg)
+{
+    switch(msg->type)
+    {
+        case MSG_JOIN:
+            if(msg->arg <= JOIN_ANY) join(p, msg->arg); 
+            else send_msg(p, MSG_ERROR, ERROR_TYPE, msg->game); 
+            break; 
+        case MSG_MOVE:
+            move(p, msg->game, msg->arg); 
+            break; 
+        case MSG_RESIGN:
+            if(side(p, msg->game) < 0) send_msg(p, MSG_ERROR, ERROR_GAME, msg->game); 
+            else end_match(msg->game, side(p, msg->game) ^ 1, END_LEFT); 
+            break; 
+        default:
+            send_msg(p, MSG_ERROR, ERROR_TYPE, msg->game); 
+            break; 
+    }
+}
+
+// games of a closed connection are won by the other side
+void drop_peer(PEER *p)
+{
+    if(p->closed) return; 
+    for(int i = 0; i < match_count; ++i)
+    {
+        int me = side(p, i); 
+        if(me >= 0) end_match(i, me ^ 1, END_LEFT); 
+    }
+    int n = 0; 
+    for(int i = 0; i < waiting_count; ++i)
+        if(waiting[i].peer != p) waiting[n++] = waiting[i]; 
+    waiting_count = n; 
+
+    p->closed = true; 
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, p->fd, NULL); 
+    close(p->fd); 
+    --peer_count; 
+    touch(p); 
+}
+
+void read_peer(PEER *p)
+{
+    ssize_t n = read(p->fd, p->in + p->in_len, sizeof(p->in) - p->in_len); 
+    if(n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+    {
+        drop_peer(p); 
+        return; 
+    }
+    if(n < 0) return; 
+    p->in_len += n; 
+
+    size_t used = 0; 
+    while(p->in_len - used >= sizeof(MESSAGE) && !p->closed)
+    {
+        MESSAGE msg; 
+        memcpy(&msg, p->in + used, sizeof(msg)); 
+        handle(p, &msg); 
+        used += sizeof(MESSAGE); 
+    }
+    memmove(p->in, p->in + used, p->in_len - used); 
+    p->in_len -= used; 
+}
+
+// writes what it can, the rest waits until the socket has room
+void write_peer(PEER *p)
+{
+    size_t done = 0; 
+    while(done < p->out_len)
+    {
+        ssize_t n = write(p->fd, p->out + done, p->out_len - done); 
+        if(n < 0 && errno == EINTR) continue; 
+        if(n < 0 && errno == EAGAIN) break; 
+        if(n <= 0)
+        {
+            drop_peer(p); 
+            return; 
+        }
+        done += n; 
+    }
+    memmove(p->out, p->out + done, p->out_len - done); 
+    p->out_len -= done; 
+
+    struct epoll_event ev; 
+    ev.events = EPOLLIN | (p->out_len ? EPOLLOUT : 0); 
+    ev.data.ptr = p; 
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, p->fd, &ev); 
+}
+
+void flush_touched()
+{
+    // dropping a peer can touch others, so the list may grow while it is walked,
+    // and can queue replies to peers already written, which are still dirty and
+    // so not touched again: walk again until a pass drops nobody
+    for(int before = -1; before != peer_count; )
+    {
+        before = peer_count; 
+        for(int i = 0; i < touched_count; ++i)
+        {
+            PEER *p = touched[i]; 
+            if(!p->closed && p->out_len) write_peer(p); 
+        }
+    }
+    for(int i = 0; i < touched_count; ++i)
+    {
+        PEER *p = touched[i]; 
+        p->dirty = false; 
+        if(p->closed)
+        {
+            free(p->out); 
+            free(p); 
+        }
+    }
+    touched_count = 0; 
+}
+
+void accept_peers(int listen_fd)
+{
+    int fd; 
+    while((fd = accept(listen_fd, NULL, NULL)) >= 0)
+    {
+        fcntl(fd, F_SETFL, O_NONBLOCK); 
+        PEER *p = (PEER *) calloc(1, sizeof(PEER)); 
+        p->fd = fd; 
+        struct epoll_event ev; 
+        ev.events = EPOLLIN; 
+        ev.data.ptr = p; 
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev); 
+        ++peer_count; 
+    }
+}
+
+double get_time()
+{
+    struct timespec ts; 
+    clock_gettime(CLOCK_MONOTONIC, &ts); 
+    return ts.tv_sec + ts.tv_nsec / 1e9; 
+}
+
+void on_signal(int sig)
+{
+    (void) sig; 
+    quit = 1; 
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = SOCKET_FILE; 
+    bool quiet = false; 
+    int opt; 
+    while((opt = getopt(argc, argv, "s:q")) != -1)
+    {
+        switch(opt)
+        {
+            case 's': path = optarg; break; 
+            case 'q': quiet = true; break; 
+            default:
+                fprintf(stderr, "usage: %s [-s socket] [-q]\n", argv[0]); 
+                fprintf(stderr, "  -s file  socket to listen on, default %s\n", SOCKET_FILE); 
+                fprintf(stderr, "  -q       no statistics every second\n"); 
+                return 1; 
+        }
+    }
+
+    struct sockaddr_un addr; 
+    memset(&addr, 0, sizeof(addr)); 
+    addr.sun_family = AF_UNIX; 
+    if(strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "%s: path too long\n", path); 
+        return 1; 
+    }
+    strcpy(addr.sun_path, path); 
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0); 
+    unlink(path); 
+    if(listen_fd < 0 || bind(listen_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(listen_fd, 128) < 0)
+    {
+        perror(path); 
+        return 1; 
+    }
+
+    signal(SIGPIPE, SIG_IGN); 
+    signal(SIGINT, on_signal); 
+    signal(SIGTERM, on_signal); 
+
+    epoll_fd = epoll_create1(0); 
+    struct epoll_event ev; 
+    ev.events = EPOLLIN; 
+    ev.data.ptr = NULL; 
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev); 
+
+    double last = get_time(); 
+    unsigned long last_finished = 0; 
+    struct epoll_event events[MAX_EVENTS]; 
+    while(!quit)
+    {
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, 1000); 
+        for(int i = 0; i < n; ++i)
+        {
+            PEER *p = (PEER *) events[i].data.ptr; 
+            if(!p)
+                accept_peers(listen_fd); 
+            else if(!p->closed && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+                read_peer(p); 
+            else if(!p->closed && (events[i].events & EPOLLOUT))
+                touch(p); 
+        }
+        flush_touched(); 
+
+        double now = get_time(); 
+        if(!quiet && now - last >= 1)
+        {
+            if(finished != last_finished)
+                fprintf(stderr, "%d connections, %d waiting, %d games, %lu finished, %.0f games/s\n", 
+                    peer_count, waiting_count, match_count - free_count, finished, 
+                    (finished - last_finished) / (now - last)); 
+            last = now; 
+            last_finished = finished; 
+        }
+    }
+
+    close(listen_fd); 
+    unlink(path); 
+    return 0; 
+}
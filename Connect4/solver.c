@@ -0,0 +1,449 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include "solver.h"
+#include "threats.h"
+
+#define CELLS (BOARD_ROWS * BOARD_COLS)
+
+// transposition table entry bits
+#define TT_EMPTY 0
+#define TT_EXACT 1
+#define TT_LOWER 2
+#define TT_UPPER 3
+
+#define ENTRY_KEY(e) ((uint32_t) (e))
+#define ENTRY_SCORE(e) ((int) (((e) >> 32) & 0xFFFF) - 32768)
+#define ENTRY_DEPTH(e) ((int) (((e) >> 48) & 0xFF))
+#define ENTRY_FLAG(e) ((int) (((e) >> 56) & 0x3))
+#define ENTRY_MOVE(e) ((int) (((e) >> 58) & 0xF) - 1)
+
+// how often the clock is read
+#define NODES_PER_CHECK 4096
+
+#if BOARD_COLS > 14
+#error "table entries keep the move in 4 bits"
+#endif
+
+// subtrees at least this deep are looked up in and added to the cache
+#define CACHE_MIN_DEPTH 16
+
+// The table is indexed by key % size with the low 32 bits of the key stored 
+// alongside. Since size is an odd prime above 2^(key bits - 32) the two 
+// together identify the key exactly (Chinese remainder theorem). Keys longer 
+// than TT_EXACT_BITS, from cache.h, are hashed to 64 bits first, then the stored bits only make a collision 
+// unlikely. 
+// Entries are single atomic words, so threads share the table without locks 
+// and a probe never sees half of one store and half of another. 
+struct TTABLE
+{
+    unsigned long size; 
+    _Atomic uint64_t *entries; 
+    CACHE *cache;       // solved positions from earlier runs, may be NULL
+}; 
+
+// state shared by every thread searching the same root
+typedef struct SHARED
+{
+    TTABLE *tt; 
+    POSITION root; 
+    int max_depth; 
+    int remaining; 
+    int first;          // move tried first by every thread
+    double deadline;    // 0 for none
+    atomic_bool *cancel; 
+    atomic_bool stop; 
+
+    pthread_mutex_t lock; 
+    SEARCH_RESULT best; 
+    atomic_ullong nodes; 
+}SHARED; 
+
+typedef struct SEARCHER
+{
+    SHARED *shared; 
+    TTABLE *tt; 
+    int id; 
+    unsigned long long nodes; 
+    bool stop; 
+    int order[BOARD_COLS]; 
+}SEARCHER; 
+
+static double get_time()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + t.tv_nsec * 1e-9; 
+}
+
+static uint64_t tt_hash(BITBOARD key)
+{
+#if KEY_BITS <= TT_EXACT_BITS
+    return key; 
+#else
+    // splitmix64 finalizer over both halves of the key
+    uint64_t h = (uint64_t) key; 
+#if BITBOARD_BITS > 64
+    h ^= (uint64_t) (key >> 64) * 0x9E3779B97F4A7C15ull; 
+#endif
+    h ^= h >> 30; 
+    h *= 0xBF58476D1CE4E5B9ull; 
+    h ^= h >> 27; 
+    h *= 0x94D049BB133111EBull; 
+    h ^= h >> 31; 
+    return h; 
+#endif
+}
+
+static bool is_prime(unsigned long n)
+{
+    if(n < 2) return false; 
+    for(unsigned long d = 2; d * d <= n; ++d)
+        if(n % d == 0) return false; 
+    return true; 
+}
+
+TTABLE *tt_create(unsigned long entries)
+{
+#if KEY_BITS <= TT_EXACT_BITS
+    // enough for the low 32 bits to tell keys apart 
+    unsigned long min = 1ul << (KEY_BITS > 32 ? KEY_BITS - 32 : 1); 
+    if(entries < min) entries = min; 
+#endif
+    while(!is_prime(entries)) ++entries; 
+
+    TTABLE *tt = (TTABLE *) malloc(sizeof(TTABLE)); 
+    tt->size = entries; 
+    tt->entries = (_Atomic uint64_t *) calloc(entries, sizeof(uint64_t)); 
+    tt->cache = NULL; 
+    return tt; 
+}
+
+void tt_destroy(TTABLE *tt)
+{
+    free(tt->entries); 
+    free(tt); 
+}
+
+void tt_set_cache(TTABLE *tt, CACHE *cache)
+{
+    tt->cache = cache; 
+}
+
+void tt_clear(TTABLE *tt)
+{
+    memset(tt->entries, 0, tt->size * sizeof(uint64_t)); 
+}
+
+static void tt_store(TTABLE *tt, BITBOARD key, int score, int depth, int flag, int move)
+{
+    uint64_t h = tt_hash(key); 
+    uint64_t e = (uint64_t) (uint32_t) h 
+        | (uint64_t) (score + 32768) << 32 
+        | (uint64_t) depth << 48 
+        | (uint64_t) flag << 56 
+        | (uint64_t) (move + 1) << 58; 
+    atomic_store_explicit(&tt->entries[h % tt->size], e, memory_order_relaxed); 
+}
+
+static uint64_t tt_probe(const TTABLE *tt, BITBOARD key)
+{
+    uint64_t h = tt_hash(key); 
+    uint64_t e = atomic_load_explicit(&tt->entries[h % tt->size], memory_order_relaxed); 
+    if(ENTRY_FLAG(e) == TT_EMPTY || ENTRY_KEY(e) != (uint32_t) h) return 0; 
+    return e; 
+}
+
+// threats and central stones, always well inside SCORE_HEURISTIC
+static int evaluate(const POSITION *pos, const THREATS *t)
+{
+    int me = pos_player(pos); 
+    BITBOARD center = COL_MASK(BOARD_COLS / 2); 
+    int threats = pos_popcount(t->wins[me]) - pos_popcount(t->wins[me ^ 1]); 
+    int central = pos_popcount(pos->boards[me] & center) 
+        - pos_popcount(pos->boards[me ^ 1] & center); 
+    return threats * 16 + central * 2; 
+}
+
+static bool check_time(SEARCHER *s)
+{
+    if((s->nodes % NODES_PER_CHECK) == 0)
+    {
+        SHARED *sh = s->shared; 
+        if((sh->deadline && get_time() >= sh->deadline) || (sh->cancel && atomic_load(sh->cancel)))
+            atomic_store(&sh->stop, true); 
+        s->stop = atomic_load_explicit(&sh->stop, memory_order_relaxed); 
+    }
+    return s->stop; 
+}
+
+static int negamax(SEARCHER *s, POSITION *pos, int depth, int alpha, int beta)
+{
+    ++s->nodes; 
+    if(check_time(s)) return 0; 
+
+    THREATS t; 
+    threats_analyze(pos, &t); 
+
+    // win right away
+    if(t.immediate) return SCORE_WIN - (pos->moves + 1); 
+    if(pos->moves == CELLS) return 0; 
+
+    // only moves that keep them from winning next are searched, without one we lose
+    if(!t.non_losing) return -(SCORE_WIN - (pos->moves + 2)); 
+
+    if(depth > CELLS - pos->moves) depth = CELLS - pos->moves; 
+    if(depth == 0) return evaluate(pos, &t); 
+
+    // at best we win with our next stone, at worst they win with their second
+    int max = SCORE_WIN - (pos->moves + 3); 
+    int min = -(SCORE_WIN - (pos->moves + 4)); 
+    if(beta > max) beta = max; 
+    if(alpha < min) alpha = min; 
+    if(alpha >= beta) return alpha; 
+
+    BITBOARD key = pos_key(pos); 
+    uint64_t e = tt_probe(s->tt, key); 
+    int tt_move = -1; 
+    if(e)
+    {
+        tt_move = ENTRY_MOVE(e); 
+        if(ENTRY_DEPTH(e) >= depth)
+        {
+            int score = ENTRY_SCORE(e); 
+            switch(ENTRY_FLAG(e))
+            {
+                case TT_EXACT: return score; 
+                case TT_LOWER: if(score > alpha) alpha = score; break; 
+                case TT_UPPER: if(score < beta) beta = score; break; 
+            }
+            if(alpha >= beta) return score; 
+        }
+    }
+
+    // big subtrees may have been solved in an earlier run
+    int cached, cached_move; 
+    if(depth >= CACHE_MIN_DEPTH && cache_lookup(s->tt->cache, key, &cached, &cached_move))
+    {
+        tt_store(s->tt, key, cached, CELLS - pos->moves, TT_EXACT, cached_move); 
+        return cached; 
+    }
+
+    // the table's move first, then the ones that leave us the most threats
+    int moves[BOARD_COLS], weights[BOARD_COLS], n = 0; 
+    if(tt_move >= 0 && (t.non_losing & COL_MASK(tt_move)))
+    {
+        moves[n] = tt_move; 
+        weights[n++] = SCORE_INF; 
+    }
+    int me = pos_player(pos); 
+    BITBOARD mask = pos->boards[0] | pos->boards[1]; 
+    for(int i = 0; i < BOARD_COLS; ++i)
+    {
+        int c = s->order[i]; 
+        BITBOARD cell = t.non_losing & COL_MASK(c); 
+        if(!cell || c == tt_move) continue; 
+        int w = pos_popcount(threats_winning_cells(pos->boards[me] | cell, mask | cell)); 
+        int j = n++; 
+        for(; j > 0 && weights[j-1] < w; --j)
+        {
+            moves[j] = moves[j-1]; 
+            weights[j] = weights[j-1]; 
+        }
+        moves[j] = c; 
+        weights[j] = w; 
+    }
+
+    int alpha_orig = alpha; 
+    int best = -SCORE_INF, best_move = -1; 
+    for(int i = 0; i < n; ++i)
+    {
+        int c = moves[i]; 
+        pos_play(pos, c); 
+        int score = -negamax(s, pos, depth - 1, -beta, -alpha); 
+        pos_undo(pos, c); 
+        if(s->stop) return 0; 
+
+        if(score > best)
+        {
+            best = score; 
+            best_move = c; 
+        }
+        if(score > alpha) alpha = score; 
+        if(alpha >= beta) break; 
+    }
+
+    int flag = best <= alpha_orig ? TT_UPPER : best >= beta ? TT_LOWER : TT_EXACT; 
+    tt_store(s->tt, key, best, depth, flag, best_move); 
+    if(flag == TT_EXACT && depth >= CACHE_MIN_DEPTH && depth == CELLS - pos->moves)
+        cache_add(s->tt->cache, key, best, best_move); 
+    return best; 
+}
+
+// plays every move at the root and keeps the best one
+static int search_root(SEARCHER *s, POSITION *pos, int depth, int first, int *move)
+{
+    int alpha = -SCORE_INF, beta = SCORE_INF; 
+    int best_move = -1; 
+    for(int i = -1; i < BOARD_COLS; ++i)
+    {
+        int c = i < 0 ? first : s->order[i]; 
+        if(c < 0 || (i >= 0 && c == first) || !pos_can_play(pos, c)) continue; 
+
+        pos_play(pos, c); 
+        int score = -negamax(s, pos, depth - 1, -beta, -alpha); 
+        pos_undo(pos, c); 
+        if(s->stop) break; 
+
+        if(score > alpha || best_move < 0)
+        {
+            alpha = score; 
+            best_move = c; 
+        }
+    }
+    *move = best_move; 
+    return alpha; 
+}
+
+bool is_proven(int score)
+{
+    return score >= SCORE_HEURISTIC || score <= -SCORE_HEURISTIC; 
+}
+
+// columns from the center out, helpers rotate it to explore other subtrees first
+static void init_order(int *order, int id)
+{
+    for(int i = 0; i < BOARD_COLS; ++i)
+        order[i] = BOARD_COLS / 2 + (1 - 2 * (i % 2)) * (i + 1) / 2; 
+    for(int k = 0; k < id % BOARD_COLS; ++k)
+    {
+        int tmp = order[0]; 
+        memmove(order, order + 1, (BOARD_COLS - 1) * sizeof(int)); 
+        order[BOARD_COLS - 1] = tmp; 
+    }
+}
+
+// plies from the root to the end of the game a proven score promises. A table 
+// kept from earlier searches can prove a slow win at a shallow depth while a 
+// faster one is still beyond the horizon, so a proven score is only final once 
+// the iteration has looked that far. 
+static int proven_distance(const SHARED *sh, int score)
+{
+    int stones = score > 0 ? SCORE_WIN - score : SCORE_WIN + score; 
+    return stones - sh->root.moves; 
+}
+
+// keeps the deepest finished iteration from any thread
+static void publish(SHARED *sh, int depth, int score, int move)
+{
+    bool exact = depth == sh->remaining || (is_proven(score) && proven_distance(sh, score) <= depth); 
+    pthread_mutex_lock(&sh->lock); 
+    if(!sh->best.exact && (exact || depth > sh->best.depth))
+    {
+        sh->best.move = move; 
+        sh->best.score = score; 
+        sh->best.depth = depth; 
+        sh->best.exact = exact; 
+    }
+    pthread_mutex_unlock(&sh->lock); 
+    if(exact) atomic_store(&sh->stop, true); 
+}
+
+// iterative deepening until the score is proven or time runs out, 
+// odd helpers start one ply deeper so the threads spread over depths (Lazy SMP) 
+static void *search_thread(void *pargs)
+{
+    SEARCHER *s = (SEARCHER *) pargs; 
+    SHARED *sh = s->shared; 
+    POSITION pos = sh->root; 
+    int move = sh->first; 
+
+    for(int depth = 1 + (s->id & 1); depth <= sh->max_depth; ++depth)
+    {
+        int next; 
+        int score = search_root(s, &pos, depth, move, &next); 
+        if(s->stop) break; 
+        move = next; 
+        publish(sh, depth, score, move); 
+        if(atomic_load(&sh->stop)) break; 
+    }
+    atomic_fetch_add(&sh->nodes, s->nodes); 
+    return NULL; 
+}
+
+void search(const POSITION *root, TTABLE *tt, const SEARCH_LIMITS *limits, SEARCH_RESULT *result)
+{
+    double start = get_time(); 
+    SHARED sh; 
+    memset(&sh, 0, sizeof(SHARED)); 
+    sh.tt = tt; 
+    sh.root = *root; 
+    sh.deadline = limits->time_ms ? start + limits->time_ms / 1000.0 : 0; 
+    sh.cancel = limits->cancel; 
+    sh.remaining = CELLS - root->moves; 
+    sh.best.move = -1; 
+    atomic_init(&sh.stop, false); 
+    atomic_init(&sh.nodes, 0); 
+    pthread_mutex_init(&sh.lock, NULL); 
+
+    int me = pos_player(root); 
+    for(int c = 0; c < BOARD_COLS; ++c)
+        if(pos_can_play(root, c) && pos_is_win(root->boards[me] | CELL_MASK(root->heights[c], c)))
+        {
+            sh.best.move = c; 
+            sh.best.score = SCORE_WIN - (root->moves + 1); 
+            sh.best.exact = true; 
+            sh.remaining = 0; 
+            break; 
+        }
+    int score, move; 
+    if(!sh.best.exact && cache_lookup(tt->cache, pos_key(root), &score, &move) && move >= 0)
+    {
+        sh.best.move = move; 
+        sh.best.score = score; 
+        sh.best.exact = true; 
+        sh.remaining = 0; 
+    }
+    bool known = sh.best.exact; 
+    sh.first = sh.best.move; 
+    sh.max_depth = limits->max_depth && limits->max_depth < sh.remaining 
+        ? limits->max_depth : sh.remaining; 
+
+    int threads = limits->threads > 1 ? limits->threads : 1; 
+    SEARCHER searchers[threads]; 
+    pthread_t ids[threads]; 
+    for(int i = 0; i < threads; ++i)
+    {
+        memset(&searchers[i], 0, sizeof(SEARCHER)); 
+        searchers[i].shared = &sh; 
+        searchers[i].tt = tt; 
+        searchers[i].id = i; 
+        init_order(searchers[i].order, i); 
+    }
+    for(int i = 1; i < threads; ++i)
+        pthread_create(&ids[i], NULL, search_thread, &searchers[i]); 
+    search_thread(&searchers[0]); 
+
+    // the main thread is done, helpers stop at their next check
+    atomic_store(&sh.stop, true); 
+    for(int i = 1; i < threads; ++i)
+        pthread_join(ids[i], NULL); 
+    pthread_mutex_destroy(&sh.lock); 
+
+    *result = sh.best; 
+    if(result->exact && !known)
+        cache_add(tt->cache, pos_key(root), result->score, result->move); 
+    result->nodes = atomic_load(&sh.nodes); 
+    result->secs = get_time() - start; 
+}
+
+int solve(const POSITION *pos, TTABLE *tt, int threads, SEARCH_RESULT *result)
+{
+    SEARCH_LIMITS limits = { .threads = threads }; 
+    search(pos, tt, &limits, result); 
+    return result->score; 
+}
@@ -0,0 +1,50 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "cache.h"
+#include "position.h"
+
+// Scores are from the point of view of the player to move. A win scores 
+// SCORE_WIN minus the number of stones on the board once it is won, so faster 
+// wins score higher and a score means the same thing at every depth. Anything 
+// smaller than SCORE_HEURISTIC is a guess from the evaluation. 
+#define SCORE_WIN 10000
+#define SCORE_HEURISTIC 1000
+#define SCORE_INF 32000
+
+#define DEFAULT_TT_ENTRIES (1 << 22)
+
+typedef struct TTABLE TTABLE; 
+
+TTABLE *tt_create(unsigned long entries); 
+void tt_destroy(TTABLE *tt); 
+void tt_clear(TTABLE *tt); 
+void tt_set_cache(TTABLE *tt, CACHE *cache); 
+
+typedef struct SEARCH_LIMITS
+{
+    int time_ms;        // 0 for no limit
+    int max_depth;      // 0 for no limit
+    int threads;        // helpers share the table, 0 or 1 searches alone
+    atomic_bool *cancel;    // another thread sets it to stop early, NULL for none
+}SEARCH_LIMITS; 
+
+typedef struct SEARCH_RESULT
+{
+    int move;           // column, -1 if the game is over
+    int score; 
+    int depth;          // deepest iteration that finished
+    bool exact;         // score is proven, not a heuristic
+    unsigned long long nodes; 
+    double secs; 
+}SEARCH_RESULT; 
+
+void search(const POSITION *pos, TTABLE *tt, const SEARCH_LIMITS *limits, SEARCH_RESULT *result); 
+int solve(const POSITION *pos, TTABLE *tt, int threads, SEARCH_RESULT *result); 
+
+bool is_proven(int score); 
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef THREATS_H
+#define THREATS_H
+
+#include "position.h"
+
+// Threats of a position, the empty cells where a stone would complete a line.
+// Everything is a few shifts and masks over the bitboards, cheap enough for
+// the search to run at every node and the board at every redraw.
+typedef struct THREATS
+{
+    BITBOARD playable;          // lowest empty cell of every column that is not full
+    BITBOARD wins[2];           // empty cells that complete a line for red and yellow
+    BITBOARD immediate;         // playable cells the player to move wins on
+    BITBOARD forced;            // playable cells the opponent wins on next, to be blocked
+    BITBOARD non_losing;        // playable cells that do not let the opponent win next
+}THREATS; 
+
+#if WIN_LENGTH == 4
+// empty cells that would complete four in a row for the stones in b
+static inline BITBOARD threats_winning_cells(BITBOARD b, BITBOARD mask)
+{
+    // vertical
+    BITBOARD r = (b << 1) & (b << 2) & (b << 3); 
+
+    // horizontal and both diagonals
+    static const int shifts[3] = { COL_BITS, COL_BITS - 1, COL_BITS + 1 }; 
+    for(int i = 0; i < 3; ++i)
+    {
+        int s = shifts[i]; 
+        BITBOARD p = (b << s) & (b << 2*s); 
+        r |= p & (b << 3*s); 
+        r |= p & (b >> s); 
+        p = (b >> s) & (b >> 2*s); 
+        r |= p & (b << s); 
+        r |= p & (b >> 3*s); 
+    }
+    return r & (BOARD_MASK ^ mask); 
+}
+#else
+// the same for any length, a cell wins if it has g stones on one side and 
+// WIN_LENGTH - 1 - g on the other for some g
+static inline BITBOARD threats_winning_cells(BITBOARD b, BITBOARD mask)
+{
+    static const int shifts[4] = { 1, COL_BITS, COL_BITS - 1, COL_BITS + 1 }; 
+    BITBOARD r = 0; 
+    for(int i = 0; i < 4; ++i)
+    {
+        // cells with at least k stones in a row above and below along the direction
+        BITBOARD above[WIN_LENGTH], below[WIN_LENGTH]; 
+        above[0] = below[0] = ~(BITBOARD) 0; 
+        for(int k = 1; k < WIN_LENGTH; ++k)
+        {
+            above[k] = above[k-1] & (b >> k * shifts[i]); 
+            below[k] = below[k-1] & (b << k * shifts[i]); 
+        }
+        for(int g = 0; g < WIN_LENGTH; ++g)
+            r |= above[g] & below[WIN_LENGTH-1 - g]; 
+    }
+    return r & (BOARD_MASK ^ mask); 
+}
+#endif
+
+static inline void threats_analyze(const POSITION *pos, THREATS *t)
+{
+    int me = pos_player(pos); 
+    BITBOARD mask = pos->boards[0] | pos->boards[1]; 
+    t->playable = (mask + BOTTOM_ROW) & BOARD_MASK; 
+    t->wins[0] = threats_winning_cells(pos->boards[0], mask); 
+    t->wins[1] = threats_winning_cells(pos->boards[1], mask); 
+    t->immediate = t->wins[me] & t->playable; 
+    t->forced = t->wins[me ^ 1] & t->playable; 
+
+    // two cells to block cannot both be blocked, otherwise block the one there 
+    // is and never play right below a cell the opponent wins on
+    BITBOARD moves = t->playable; 
+    if(t->forced) moves = t->forced & (t->forced - 1) ? 0 : t->forced; 
+    t->non_losing = moves & ~(t->wins[me ^ 1] >> 1); 
+}
+
+#endif
@@ -0,0 +1,348 @@
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <pthread.h>
+
+#include "solver.h"
+
+// openings are lines of OPENING_PLIES moves a search to OPENING_DEPTH thinks
+// are close to even, without a proven result for either side
+#define OPENING_PLIES 4
+#define OPENING_DEPTH 8
+#define OPENING_BALANCE 20
+#define MAX_OPENINGS 4096
+#define MAX_MOVES (BOARD_ROWS * BOARD_COLS)
+
+// each worker keeps its own tables, smaller than the game's
+#define WORKER_TT_ENTRIES (1 << 20)
+
+typedef struct ENGINE
+{
+    char name[64]; 
+    SEARCH_LIMITS limits; 
+}ENGINE; 
+
+typedef struct GAME
+{
+    int opening; 
+    int red;                    // engine playing red, 0 for a and 1 for b
+    int winner;                 // engine that won, -1 for a draw
+    int plies; 
+    char moves[MAX_MOVES + 1]; 
+    float secs[MAX_MOVES];      // time each move took, 0 for opening moves
+}GAME; 
+
+typedef struct TOURNAMENT
+{
+    ENGINE engines[2]; 
+    char openings[MAX_OPENINGS][OPENING_PLIES + 1]; 
+    int opening_count; 
+    GAME *games; 
+    int game_count; 
+    atomic_int next; 
+    atomic_int done; 
+}TOURNAMENT; 
+
+// "t=50,d=0,j=1" for 50 ms a move, no depth limit, one thread
+bool parse_engine(const char *spec, ENGINE *e)
+{
+    memset(e, 0, sizeof(ENGINE)); 
+    snprintf(e->name, sizeof(e->name), "%s", spec); 
+    char buf[64]; 
+    snprintf(buf, sizeof(buf), "%s", spec); 
+    char *save; 
+    for(char *tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save))
+    {
+        char key; 
+        int value; 
+        if(sscanf(tok, "%c=%d", &key, &value) != 2) return false; 
+        switch(key)
+        {
+            case 't': e->limits.time_ms = value; break; 
+            case 'd': e->limits.max_depth = value; break; 
+            case 'j': e->limits.threads = value; break; 
+            default: return false; 
+        }
+    }
+    return e->limits.time_ms || e->limits.max_depth; 
+}
+
+static BITBOARD canonical_key(const POSITION *pos)
+{
+    BITBOARD key = pos_key(pos), mirror = pos_mirror(key); 
+    return mirror < key ? mirror : key; 
+}
+
+// every line of OPENING_PLIES moves once up to mirroring, kept if it is balanced
+void find_openings(TOURNAMENT *t, TTABLE *tt, POSITION *pos, char *line, int ply, 
+    BITBOARD *seen, int *nseen)
+{
+    if(ply == OPENING_PLIES)
+    {
+        BITBOARD key = canonical_key(pos); 
+        for(int i = 0; i < *nseen; ++i)
+            if(seen[i] == key) return; 
+        seen[(*nseen)++] = key; 
+
+        SEARCH_LIMITS limits = { .max_depth = OPENING_DEPTH, .threads = 1 }; 
+        SEARCH_RESULT result; 
+        search(pos, tt, &limits, &result); 
+        if(!is_proven(result.score) && abs(result.score) <= OPENING_BALANCE && t->opening_count < MAX_OPENINGS)
+        {
+            memcpy(t->openings[t->opening_count], line, OPENING_PLIES); 
+            t->openings[t->opening_count++][OPENING_PLIES] = '\0'; 
+        }
+        return; 
+    }
+
+    int me = pos_player(pos); 
+    for(int c = 0; c < BOARD_COLS; ++c)
+    {
+        if(!pos_can_play(pos, c) || pos_is_win(pos->boards[me] | CELL_MASK(pos->heights[c], c)))
+            continue; 
+        pos_play(pos, c); 
+        line[ply] = '1' + c; 
+        find_openings(t, tt, pos, line, ply + 1, seen, nseen); 
+        pos_undo(pos, c); 
+    }
+}
+
+// same order on every run so results can be compared
+void shuffle_openings(TOURNAMENT *t, unsigned int seed)
+{
+    for(int i = t->opening_count - 1; i > 0; --i)
+    {
+        seed = seed * 1103515245 + 12345; 
+        int j = (seed >> 8) % (i + 1); 
+        char tmp[OPENING_PLIES + 1]; 
+        memcpy(tmp, t->openings[i], sizeof(tmp)); 
+        memcpy(t->openings[i], t->openings[j], sizeof(tmp)); 
+        memcpy(t->openings[j], tmp, sizeof(tmp)); 
+    }
+}
+
+bool read_openings(TOURNAMENT *t, const char *path)
+{
+    FILE *f = fopen(path, "r"); 
+    if(!f) return false; 
+    char line[128]; 
+    while(t->opening_count < MAX_OPENINGS && fgets(line, sizeof(line), f))
+    {
+        line[strcspn(line, " \r\n")] = '\0'; 
+        if(line[0] == '\0') continue; 
+        POSITION pos; 
+        if(strlen(line) > OPENING_PLIES || pos_from_moves(&pos, line) != (int) strlen(line))
+        {
+            fprintf(stderr, "%s: skipping %s\n", path, line); 
+            continue; 
+        }
+        strcpy(t->openings[t->opening_count++], line); 
+    }
+    fclose(f); 
+    return true; 
+}
+
+void play_game(const TOURNAMENT *t, GAME *g, TTABLE *tts[2])
+{
+    POSITION pos; 
+    int n = pos_from_moves(&pos, t->openings[g->opening]); 
+    memcpy(g->moves, t->openings[g->opening], n); 
+    g->winner = -1; 
+    tt_clear(tts[0]); 
+    tt_clear(tts[1]); 
+
+    while(!pos_is_full(&pos))
+    {
+        int player = pos_player(&pos); 
+        int engine = player == 0 ? g->red : g->red ^ 1; 
+        SEARCH_RESULT result; 
+        search(&pos, tts[engine], &t->engines[engine].limits, &result); 
+
+        g->secs[pos.moves] = result.secs; 
+        g->moves[pos.moves] = '1' + result.move; 
+        pos_play(&pos, result.move); 
+        if(pos_is_win(pos.boards[player]))
+        {
+            g->winner = engine; 
+            break; 
+        }
+    }
+    g->plies = pos.moves; 
+    g->moves[pos.moves] = '\0'; 
+}
+
+void *worker(void *pargs)
+{
+    TOURNAMENT *t = (TOURNAMENT *) pargs; 
+    TTABLE *tts[2] = { tt_create(WORKER_TT_ENTRIES), tt_create(WORKER_TT_ENTRIES) }; 
+    int i; 
+    while((i = atomic_fetch_add(&t->next, 1)) < t->game_count)
+    {
+        play_game(t, &t->games[i], tts); 
+        int done = atomic_fetch_add(&t->done, 1) + 1; 
+        fprintf(stderr, "\r%d/%d games", done, t->game_count); 
+    }
+    tt_destroy(tts[0]); 
+    tt_destroy(tts[1]); 
+    return NULL; 
+}
+
+// rating difference for an expected score, clamped short of the infinities
+double elo(double score)
+{
+    if(score < 1e-3) score = 1e-3; 
+    if(score > 1 - 1e-3) score = 1 - 1e-3; 
+    return -400 * log10(1 / score - 1); 
+}
+
+void report(const TOURNAMENT *t)
+{
+    int wins = 0, draws = 0, losses = 0; 
+    double sum = 0, sum2 = 0; 
+    double move_secs[2] = { 0, 0 }, max_secs[2] = { 0, 0 }; 
+    int moves[2] = { 0, 0 }; 
+    for(int i = 0; i < t->game_count; ++i)
+    {
+        const GAME *g = &t->games[i]; 
+        double x = g->winner < 0 ? 0.5 : g->winner == 0 ? 1 : 0; 
+        wins += x == 1; 
+        draws += x == 0.5; 
+        losses += x == 0; 
+        sum += x; 
+        sum2 += x * x; 
+
+        for(int m = strlen(t->openings[g->opening]); m < g->plies; ++m)
+        {
+            int engine = (m & 1) == 0 ? g->red : g->red ^ 1; 
+            move_secs[engine] += g->secs[m]; 
+            if(g->secs[m] > max_secs[engine]) max_secs[engine] = g->secs[m]; 
+            ++moves[engine]; 
+        }
+    }
+
+    // normal approximation over per game scores
+    int n = t->game_count; 
+    double score = sum / n; 
+    double sd = sqrt(sum2 / n - score * score); 
+    double margin = 1.96 * sd / sqrt(n); 
+    double diff = elo(score); 
+    double lo = elo(score - margin), hi = elo(score + margin); 
+
+    printf("\n%d openings, %d games\n", t->opening_count, n); 
+    for(int e = 0; e < 2; ++e)
+        printf("%c: %-20s %8.2f ms/move mean %8.2f ms max\n", 'a' + e, t->engines[e].name, 
+            moves[e] ? move_secs[e] * 1000 / moves[e] : 0, max_secs[e] * 1000); 
+    printf("a wins %d, draws %d, losses %d, score %.1f%%\n", wins, draws, losses, score * 100); 
+    printf("elo a - b: %+.0f, 95%% interval [%+.0f, %+.0f]\n", diff, lo, hi); 
+}
+
+bool write_results(const TOURNAMENT *t, const char *path)
+{
+    FILE *f = fopen(path, "w"); 
+    if(!f) return false; 
+    fprintf(f, "game,opening,red,winner,plies,moves,move_ms\n"); 
+    for(int i = 0; i < t->game_count; ++i)
+    {
+        const GAME *g = &t->games[i]; 
+        fprintf(f, "%d,%s,%c,%c,%d,%s,", i, t->openings[g->opening], 'a' + g->red, 
+            g->winner < 0 ? '-' : 'a' + g->winner, g->plies, g->moves); 
+        int first = strlen(t->openings[g->opening]); 
+        for(int m = first; m < g->plies; ++m)
+            fprintf(f, "%s%.3f", m > first ? " " : "", g->secs[m] * 1000); 
+        fprintf(f, "\n"); 
+    }
+    fclose(f); 
+    return true; 
+}
+
+void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-a engine] [-b engine] [-n openings] [-j threads] [-o file] [-r file]\n", prog); 
+    fprintf(stderr, "  -a, -b     engines such as t=50,d=0,j=1 for 50 ms a move, no depth limit, one thread\n"); 
+    fprintf(stderr, "  -n count   openings to play, each twice with colors swapped\n"); 
+    fprintf(stderr, "  -j n       games played at once, default one per cpu\n"); 
+    fprintf(stderr, "  -o file    openings, one line of moves each, instead of generated ones\n"); 
+    fprintf(stderr, "  -r file    write every game and its move times as csv\n"); 
+}
+
+int main(int argc, char **argv)
+{
+    static TOURNAMENT t; 
+    const char *a = "t=10", *b = "t=20"; 
+    const char *openings_path = NULL, *results_path = NULL; 
+    int count = 20, threads = (int) sysconf(_SC_NPROCESSORS_ONLN); 
+    int opt; 
+    while((opt = getopt(argc, argv, "a:b:n:j:o:r:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'a': a = optarg; break; 
+            case 'b': b = optarg; break; 
+            case 'n': count = atoi(optarg); break; 
+            case 'j': threads = atoi(optarg); break; 
+            case 'o': openings_path = optarg; break; 
+            case 'r': results_path = optarg; break; 
+            default: usage(argv[0]); return 1; 
+        }
+    }
+    if(!parse_engine(a, &t.engines[0]) || !parse_engine(b, &t.engines[1]) || count < 1)
+    {
+        usage(argv[0]); 
+        return 1; 
+    }
+    if(threads < 1) threads = 1; 
+
+    if(openings_path)
+    {
+        if(!read_openings(&t, openings_path))
+        {
+            perror(openings_path); 
+            return 1; 
+        }
+    }
+    else
+    {
+        TTABLE *tt = tt_create(WORKER_TT_ENTRIES); 
+        POSITION pos; 
+        pos_init(&pos); 
+        char line[OPENING_PLIES + 1]; 
+        static BITBOARD seen[MAX_OPENINGS * 2]; 
+        int nseen = 0; 
+        find_openings(&t, tt, &pos, line, 0, seen, &nseen); 
+        tt_destroy(tt); 
+        shuffle_openings(&t, 1); 
+    }
+    if(count < t.opening_count) t.opening_count = count; 
+    if(t.opening_count == 0)
+    {
+        fprintf(stderr, "no openings\n"); 
+        return 1; 
+    }
+
+    // every opening twice, a plays red in the first game and yellow in the second
+    t.game_count = 2 * t.opening_count; 
+    t.games = (GAME *) calloc(t.game_count, sizeof(GAME)); 
+    for(int i = 0; i < t.game_count; ++i)
+    {
+        t.games[i].opening = i / 2; 
+        t.games[i].red = i % 2; 
+    }
+    atomic_init(&t.next, 0); 
+    atomic_init(&t.done, 0); 
+
+    pthread_t ids[threads]; 
+    for(int i = 0; i < threads; ++i)
+        pthread_create(&ids[i], NULL, worker, &t); 
+    for(int i = 0; i < threads; ++i)
+        pthread_join(ids[i], NULL); 
+
+    report(&t); 
+    if(results_path && !write_results(&t, results_path))
+        perror(results_path); 
+    free(t.games); 
+    return 0; 
+}
@@ -4,153 +4,169 @@
 #include <time.h>
 
 #include <ncurses.h>
-#include <unistd.h>
+
+#include "arcade.h"
+#include "canvas.h"
+#include "life.h"
+#include "prof.h"
+#include "term.h"
 
 #define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
 #define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
 
+// one generation a second
+#define STEP_SECS 1.0
+
 const double ratio = 0.5; 
 int height, width; 
 int starty, startx;
 
-const char title[] = "Game of Life"; 
-WINDOW *game_win; 
+const char life_title[] = "Game of Life"; 
+WINDOW *life_win; 
+CANVAS *life_canvas; 
+WINDOW *status_win;     // the line under the grid
+CANVAS *status_canvas; 
 
-struct cell
-{
-    int y, x; /* drawing coordinates only */ 
-    bool alive; 
-    int neighbors; 
-}; 
+double distribution = 0.5; 
+int total; 
+char status[80]; 
+double next_step;       // when the next generation is due
+bool dirty;             // something to draw since the last frame
 
-int rows, cols; 
-struct cell **grid; 
+void life_init(); 
+void life_start(); 
+int life_tick(); 
+int life_render(); 
+void life_shutdown(); 
 
-struct cell **create_grid(int, int, double); 
-void delete_grid(struct cell **, int); 
 void draw_grid(); 
-bool is_valid(int, int); 
-int alive_neighbors(int, int); 
-int step(); 
+void redraw(); 
+
+const ARCADE_GAME life_game = {
+    "Game of Life", 
+    life_init, 
+    life_start, 
+    life_tick, 
+    life_render, 
+    life_shutdown
+}; 
 
+#ifndef NARCADE_LAUNCHER
 int main(int argc, char **argv) 
 {
-    double distribution = argc >= 2 ? atof(argv[1]) : 0.5; 
-    int ch; 
-    int total; 
-    char status[80]; 
-
-    srand(time(0)); 
-    initscr(); 
-    refresh(); 
-    cbreak(); 
-    nodelay(stdscr, TRUE); 
-    keypad(stdscr, TRUE); 
-    curs_set(0); 
-
-    printw("Press F1 to exit"); 
+    distribution = argc >= 2 ? atof(argv[1]) : 0.5; 
+    srand(prof_seed()); 
+    arcade_main(&life_game); 
+}
+#endif
+
+static double get_time()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + t.tv_nsec * 1e-9; 
+}
+
+void life_init()
+{
     height = MIN(LINES, COLS/2) * ratio; 
     width = height * 2; 
     starty = (LINES - height) / 2; 
     startx = (COLS - width) / 2; 
-    game_win = newwin(height, width, starty, startx);
-    box(game_win, 0, 0); 
-    wrefresh(game_win); 
-    mvprintw(starty-1, startx + (width - strlen(title))/2, "%s", title); 
-    refresh(); 
+    life_win = newwin(height, width, starty, startx); 
+    life_canvas = canvas_create(life_win); 
+    status_win = newwin(1, width, starty + height, startx); 
+    status_canvas = canvas_create(status_win); 
 
     rows = height - 2; 
     cols = (width - 2) / 2; 
     total = rows * cols; 
     grid = create_grid(rows, cols, distribution); 
+}
+
+void life_start()
+{
+    erase(); 
+    printw("Press F1 to exit, P for frame times"); 
+    mvprintw(starty-1, startx + (width - strlen(life_title))/2, "%s", life_title); 
+    wnoutrefresh(stdscr); 
+    canvas_clear(life_canvas); 
+    canvas_box(life_canvas); 
+    canvas_invalidate(life_canvas); 
+    canvas_invalidate(status_canvas); 
+
+    fill_grid(grid, rows, cols, distribution); 
+    status[0] = '\0'; 
+    next_step = get_time() + STEP_SECS; 
+    dirty = true; 
+}
 
-    while((ch = getch()) != KEY_F(1))
+// waits for a key until the next generation is due
+int life_tick()
+{
+    int wait = (int) ((next_step - get_time()) * 1000 + 0.5); 
+    timeout(wait > 0 ? wait : 0); 
+    int ch = getch(); 
+    if(ch == KEY_F(1)) return 0; 
+    if(ch == 'p' || ch == 'P')
     {
-        draw_grid(); 
-        move(starty+height, startx); 
-        clrtoeol(); 
-        mvprintw(starty+height, startx + (width - strlen(status))/2, "%s", status); 
-        refresh(); 
-        sleep(1); 
-        int n = step(); 
-        sprintf(status, "%d/%d alive", n, total);    
+        PROF_SCOPE(PROF_INPUT) if(!prof_toggle_overlay()) redraw(); 
+        dirty = true; 
     }
 
-    delete_grid(grid, rows); 
-    delwin(game_win); 
-    endwin(); 
+    double now = get_time(); 
+    if(now >= next_step)
+    {
+        int n; 
+        PROF_SCOPE(PROF_SIM) n = step(); 
+        sprintf(status, "%d/%d alive", n, total);    
+        // a late generation does not make the next ones come sooner
+        next_step = MAX(next_step + STEP_SECS, now); 
+        dirty = true; 
+    }
+    return 1; 
 }
 
-struct cell **create_grid(int rows, int cols, double distribution)
+int life_render()
 {
-    struct cell **gr = (struct cell **) malloc(rows * sizeof(struct cell *)); 
-    for(int i = 0; i < rows; ++i)
-    {
-        gr[i] = (struct cell *) malloc(cols * sizeof(struct cell));  
-        for(int j = 0; j < cols; ++j)
-        {
-            gr[i][j].y = i+1; 
-            gr[i][j].x = 2*j + 1; 
-            gr[i][j].alive = (double) rand() / RAND_MAX <= distribution; 
-        }
-    }
-    return gr; 
+    if(!dirty) return 0; 
+    draw_grid(); 
+    canvas_clear(status_canvas); 
+    canvas_print(status_canvas, 0, (width - (int) strlen(status)) / 2, A_NORMAL, status); 
+    canvas_flush(status_canvas); 
+    term_frame(); 
+    dirty = false; 
+    return 1; 
 }
 
-void delete_grid(struct cell **gr, int rows)
+void life_shutdown()
 {
-    for(int i = 0; i < rows; ++i)
-        free(gr[i]); 
-    free(gr); 
+    delete_grid(grid); 
+    canvas_destroy(life_canvas); 
+    delwin(life_win); 
+    canvas_destroy(status_canvas); 
+    delwin(status_win); 
 }
 
+// only the cells that were born or died since the last generation are sent
 void draw_grid()
 {
     for(int i = 0; i < rows; ++i)
         for(int j = 0; j < cols; ++j)
         {
             struct cell c = grid[i][j]; 
-            if(c.alive)
-                wattrset(game_win, A_REVERSE); 
-            else 
-                wattrset(game_win, A_NORMAL); 
-            mvwprintw(game_win, c.y, c.x, "  "); 
+            canvas_fill(life_canvas, c.y, c.x, 1, 2, ' ' | (c.alive ? A_REVERSE : A_NORMAL)); 
         }
-    wrefresh(game_win); 
-}
-
-bool is_valid(int y, int x)
-{
-    return y > 0 && x > 0 &&
-        y < rows && x < cols; 
+    canvas_flush(life_canvas); 
 }
 
-int alive_neighbors(int r, int c)
+// puts back what the overlay covered
+void redraw()
 {
-    int n = 0; 
-    for(int i = r-1; i < r+2; ++i)
-        for(int j = c-1; j < c+2; ++j)
-            if(is_valid(i, j)) n += grid[i][j].alive;
-    return n - grid[r][c].alive; 
-}
-
-int step()
-{
-    // neighbors must be counted before updating
-    for(int i = 0; i < rows; ++i)
-        for(int j = 0; j < cols; ++j)
-            grid[i][j].neighbors = alive_neighbors(i, j); 
-
-    int alive = 0; 
-    for(int i = 0; i < rows; ++i)
-        for(int j = 0; j < cols; ++j)
-        {
-            int n = grid[i][j].neighbors; 
-            if(grid[i][j].alive && (n < 2 || n > 3))
-                grid[i][j].alive = false; 
-            else if(!grid[i][j].alive && n == 3)
-                grid[i][j].alive = true; 
-            alive += grid[i][j].alive; 
-        }
-    return alive; 
+    touchwin(stdscr); 
+    wnoutrefresh(stdscr); 
+    touchwin(life_win); 
+    wnoutrefresh(life_win); 
+    touchwin(status_win); 
+    wnoutrefresh(status_win); 
 }
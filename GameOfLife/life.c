@@ -0,0 +1,70 @@
+#include <stdlib.h>
+
+#include "life.h"
+
+int rows, cols; 
+struct cell **grid; 
+
+struct cell **create_grid(int rows, int cols, double distribution)
+{
+    // the row pointers and then every row, in one block
+    struct cell **gr = (struct cell **) malloc(rows * sizeof(struct cell *) 
+            + rows * cols * sizeof(struct cell)); 
+    struct cell *cells = (struct cell *) (gr + rows); 
+    for(int i = 0; i < rows; ++i)
+        gr[i] = cells + i * cols; 
+    fill_grid(gr, rows, cols, distribution); 
+    return gr; 
+}
+
+void fill_grid(struct cell **gr, int rows, int cols, double distribution)
+{
+    for(int i = 0; i < rows; ++i)
+        for(int j = 0; j < cols; ++j)
+        {
+            gr[i][j].y = i+1; 
+            gr[i][j].x = 2*j + 1; 
+            gr[i][j].alive = (double) rand() / RAND_MAX <= distribution; 
+        }
+}
+
+void delete_grid(struct cell **gr)
+{
+    free(gr); 
+}
+
+bool is_valid(int y, int x)
+{
+    return y > 0 && x > 0 &&
+        y < rows && x < cols; 
+}
+
+int alive_neighbors(int r, int c)
+{
+    int n = 0; 
+    for(int i = r-1; i < r+2; ++i)
+        for(int j = c-1; j < c+2; ++j)
+            if(is_valid(i, j)) n += grid[i][j].alive; 
+    return n - grid[r][c].alive; 
+}
+
+int step()
+{
+    // neighbors must be counted before updating
+    for(int i = 0; i < rows; ++i)
+        for(int j = 0; j < cols; ++j)
+            grid[i][j].neighbors = alive_neighbors(i, j); 
+
+    int alive = 0; 
+    for(int i = 0; i < rows; ++i)
+        for(int j = 0; j < cols; ++j)
+        {
+            int n = grid[i][j].neighbors; 
+            if(grid[i][j].alive && (n < 2 || n > 3))
+                grid[i][j].alive = false; 
+            else if(!grid[i][j].alive && n == 3)
+                grid[i][j].alive = true; 
+            alive += grid[i][j].alive; 
+        }
+    return alive; 
+}
@@ -0,0 +1,27 @@
+#ifndef LIFE_H
+#define LIFE_H
+
+#include <stdbool.h>
+
+// The simulation, without curses. step() advances grid by one generation and
+// returns the number of live cells. fill_grid() starts a grid over with new
+// random cells. 
+
+struct cell
+{
+    int y, x; /* drawing coordinates only */ 
+    bool alive; 
+    int neighbors; 
+}; 
+
+extern int rows, cols; 
+extern struct cell **grid; 
+
+struct cell **create_grid(int, int, double); 
+void fill_grid(struct cell **, int, int, double); 
+void delete_grid(struct cell **); 
+bool is_valid(int, int); 
+int alive_neighbors(int, int); 
+int step(); 
+
+#endif
@@ -0,0 +1,119 @@
+#include <string.h>
+
+#include "board.h"
+
+#define ROW_BITS(t, i) (((t) >> 4*(i)) & 0xF)
+#define COLS_MASK(n) ((BOARD_ROW) ((1ull << (n)) - 1))
+
+int board_fits(const BOARD_ROW *rows, int nrows, int ncols, TMASK t, int y, int x)
+{
+    if(x < 0 || y < 0) return 0; 
+    BOARD_ROW walls = ~COLS_MASK(ncols); 
+    for(int i = 0; i < 4; ++i)
+    {
+        BOARD_ROW bits = (BOARD_ROW) ROW_BITS(t, i) << x; 
+        if(!bits)                       continue; 
+        if(y + i >= nrows)              return 0; 
+        if(bits & (walls | rows[y+i]))  return 0; 
+    }
+    return 1; 
+}
+
+void board_place(BOARD_ROW *rows, TMASK t, int y, int x)
+{
+    for(int i = 0; i < 4; ++i)
+        rows[y+i] |= (BOARD_ROW) ROW_BITS(t, i) << x; 
+}
+
+// lowest row the tetromino can fall to from (y, x)
+int board_drop(const BOARD_ROW *rows, int nrows, int ncols, TMASK t, int y, int x)
+{
+    while(board_fits(rows, nrows, ncols, t, y+1, x))
+        ++y; 
+    return y; 
+}
+
+int board_is_full(BOARD_ROW row, int ncols)
+{
+    BOARD_ROW full = COLS_MASK(ncols); 
+    return (row & full) == full; 
+}
+
+// removes full rows and shifts everything above them down 
+int board_clear_lines(BOARD_ROW *rows, int nrows, int ncols)
+{
+    int dst = nrows - 1; 
+    for(int src = nrows - 1; src >= 0; --src)
+        if(!board_is_full(rows[src], ncols))
+            rows[dst--] = rows[src]; 
+    int cleared = dst + 1; 
+    memset(rows, 0, cleared * sizeof(BOARD_ROW)); 
+    return cleared; 
+}
+
+// Every distinct lock position reachable from the spawn point using the moves 
+// the game allows (left, right, clockwise rotation and soft drop). 
+// Rotations with the same shape are folded onto the first one so each set of 
+// locked cells is reported once. 
+int board_placements(const BOARD_ROW *rows, int nrows, int ncols, 
+        const TMASK rots[4], PLACEMENT *out)
+{
+    // visited states and reported locks, indexed [row][rotation] by column bit
+    BOARD_ROW seen[BOARD_MAX_ROWS][4]; 
+    BOARD_ROW locked[BOARD_MAX_ROWS][4]; 
+    memset(seen, 0, nrows * sizeof(seen[0])); 
+    memset(locked, 0, nrows * sizeof(locked[0])); 
+
+    int canon[4]; 
+    for(int r = 0; r < 4; ++r)
+    {
+        canon[r] = r; 
+        for(int k = 0; k < r && canon[r] == r; ++k)
+            if(rots[k] == rots[r]) canon[r] = k; 
+    }
+
+    // states are packed as r << 11 | y << 5 | x
+    unsigned short queue[MAX_PLACEMENTS]; 
+    int head = 0, tail = 0, n = 0; 
+
+    int sx = (ncols - mask_width(rots[0])) / 2; 
+    if(!board_fits(rows, nrows, ncols, rots[0], 0, sx)) return 0; 
+    seen[0][0] |= 1u << sx; 
+    queue[tail++] = sx; 
+
+    while(head < tail)
+    {
+        int s = queue[head++]; 
+        int r = s >> 11, y = (s >> 5) & 0x3F, x = s & 0x1F; 
+        TMASK t = rots[r]; 
+
+        int next[4][3] = {
+            { r, y, x-1 }, 
+            { r, y, x+1 }, 
+            { (r+1) & 3, y, x }, 
+            { r, y+1, x }
+        }; 
+        for(int k = 0; k < 4; ++k)
+        {
+            int nr = next[k][0], ny = next[k][1], nx = next[k][2]; 
+            if(nx < 0 || nx >= ncols || ny >= nrows) continue; 
+            if((seen[ny][nr] >> nx) & 1) continue; 
+            if(!board_fits(rows, nrows, ncols, rots[nr], ny, nx)) continue; 
+            seen[ny][nr] |= 1u << nx; 
+            queue[tail++] = nr << 11 | ny << 5 | nx; 
+        }
+
+        if(!board_fits(rows, nrows, ncols, t, y+1, x))
+        {
+            int c = canon[r]; 
+            if((locked[y][c] >> x) & 1) continue; 
+            locked[y][c] |= 1u << x; 
+            out[n].t = t; 
+            out[n].r = c; 
+            out[n].y = y; 
+            out[n].x = x; 
+            ++n; 
+        }
+    }
+    return n; 
+}
@@ -0,0 +1,31 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "tetromino.h"
+
+#define BOARD_MAX_ROWS 64
+#define BOARD_MAX_COLS 32
+
+// one bit per column, bit j is column j, row 0 is the top of the well
+typedef unsigned int BOARD_ROW; 
+
+int board_fits(const BOARD_ROW *rows, int nrows, int ncols, TMASK t, int y, int x); 
+void board_place(BOARD_ROW *rows, TMASK t, int y, int x); 
+int board_drop(const BOARD_ROW *rows, int nrows, int ncols, TMASK t, int y, int x); 
+
+int board_is_full(BOARD_ROW row, int ncols); 
+int board_clear_lines(BOARD_ROW *rows, int nrows, int ncols); 
+
+// a spot where a tetromino can lock, r indexes the rotations passed in
+typedef struct PLACEMENT
+{
+    TMASK t; 
+    signed char r, y, x; 
+}PLACEMENT; 
+
+#define MAX_PLACEMENTS (4 * BOARD_MAX_ROWS * BOARD_MAX_COLS)
+
+int board_placements(const BOARD_ROW *rows, int nrows, int ncols, 
+        const TMASK rots[4], PLACEMENT *out); 
+
+#endif
@@ -0,0 +1,155 @@
+#include <stdatomic.h>
+#include <time.h>
+
+#include <ncurses.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "input.h"
+
+// must be a power of 2
+#define RING_SIZE 256
+
+// an escape byte on its own is a key after this many ms
+#define ESC_TIMEOUT 25
+
+static INPUT_EVENT g_ring[RING_SIZE]; 
+static atomic_uint g_head;     // next slot to read, owned by the game loop
+static atomic_uint g_tail;     // next slot to write, owned by the reader
+
+static pthread_t g_reader; 
+static int g_wake[2] = { -1, -1 }; 
+static int g_running; 
+
+double input_time()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + t.tv_nsec * 1e-9; 
+}
+
+static void push(int key, double time)
+{
+    unsigned int tail = atomic_load_explicit(&g_tail, memory_order_relaxed); 
+    unsigned int head = atomic_load_explicit(&g_head, memory_order_acquire); 
+    if(tail - head == RING_SIZE) return; // full, the game loop is not draining
+
+    g_ring[tail & (RING_SIZE - 1)].key = key; 
+    g_ring[tail & (RING_SIZE - 1)].time = time; 
+    atomic_store_explicit(&g_tail, tail + 1, memory_order_release); 
+}
+
+int input_poll(INPUT_EVENT *ev)
+{
+    unsigned int head = atomic_load_explicit(&g_head, memory_order_relaxed); 
+    unsigned int tail = atomic_load_explicit(&g_tail, memory_order_acquire); 
+    if(head == tail) return 0; 
+
+    *ev = g_ring[head & (RING_SIZE - 1)]; 
+    atomic_store_explicit(&g_head, head + 1, memory_order_release); 
+    return 1; 
+}
+
+static int arrow(unsigned char c)
+{
+    switch(c)
+    {
+        case 'A': return KEY_UP; 
+        case 'B': return KEY_DOWN; 
+        case 'C': return KEY_RIGHT; 
+        case 'D': return KEY_LEFT; 
+        default: return 0; 
+    }
+}
+
+// turns bytes into keys, arrows arrive as ESC [ x or ESC O x
+static void *reader(void *pargs)
+{
+    (void) pargs; 
+    struct pollfd fds[2] = {
+        { STDIN_FILENO, POLLIN, 0 }, 
+        { g_wake[0], POLLIN, 0 }
+    }; 
+    int len = 0; 
+    double seq_time = 0; 
+
+    while(1)
+    {
+        if(poll(fds, 2, len ? ESC_TIMEOUT : -1) < 0) continue; 
+        if(fds[1].revents) break; 
+
+        if(!fds[0].revents)
+        {
+            // lone escape
+            push(27, seq_time); 
+            len = 0; 
+            continue; 
+        }
+
+        unsigned char buf[64]; 
+        int n = read(STDIN_FILENO, buf, sizeof(buf)); 
+        if(n <= 0) break; 
+        double now = input_time(); 
+
+        for(int i = 0; i < n; ++i)
+        {
+            unsigned char c = buf[i]; 
+            if(len == 0 && c == 27)
+            {
+                seq_time = now; 
+                len = 1; 
+            }
+            else if(len == 1)
+            {
+                if(c == '[' || c == 'O') 
+                    len = 2; 
+                else
+                {
+                    push(27, seq_time); 
+                    push(c, now); 
+                    len = 0; 
+                }
+            }
+            else if(len == 2)
+            {
+                // unknown sequences are dropped
+                if(arrow(c)) push(arrow(c), seq_time); 
+                len = 0; 
+            }
+            else push(c, now); 
+        }
+    }
+    return NULL; 
+}
+
+int input_start()
+{
+    if(g_running) return 1; 
+    if(pipe(g_wake) < 0) return 0; 
+
+    // curses peeks at stdin for typeahead while refreshing, which now belongs to us 
+    typeahead(-1); 
+    atomic_store(&g_head, 0); 
+    atomic_store(&g_tail, 0); 
+    if(pthread_create(&g_reader, NULL, reader, NULL))
+    {
+        close(g_wake[0]); 
+        close(g_wake[1]); 
+        return 0; 
+    }
+    g_running = 1; 
+    return 1; 
+}
+
+void input_stop()
+{
+    if(!g_running) return; 
+    char c = 0; 
+    write(g_wake[1], &c, 1); 
+    pthread_join(g_reader, NULL); 
+    close(g_wake[0]); 
+    close(g_wake[1]); 
+    typeahead(STDIN_FILENO); 
+    g_running = 0; 
+}
@@ -0,0 +1,22 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+// Keyboard input read on its own thread. 
+// Keys are stamped with the monotonic clock as soon as they arrive and queued 
+// in a single-producer single-consumer ring that the game loop drains every 
+// tick. Curses must not read the keyboard between input_start() and 
+// input_stop(). 
+
+typedef struct INPUT_EVENT
+{
+    int key;        // byte read or a curses KEY_* for the arrows
+    double time;    // seconds, same clock as input_time()
+}INPUT_EVENT; 
+
+int input_start(); 
+void input_stop(); 
+
+int input_poll(INPUT_EVENT *ev); 
+double input_time(); 
+
+#endif
@@ -0,0 +1,297 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "board.h"
+
+// Counts the placement sequences reachable from a board, like chess perft. 
+// With no arguments every reference position is checked against its known 
+// count, which makes this the oracle for any change to movement or collision. 
+//
+// usage: perft [-d depth] [-p pieces] [-b board] [-j threads]
+//     pieces is a string such as "TIOLJSZ", repeated when shorter than depth
+//     board is a file of '.' and '#' rows, the last line is the bottom
+
+#define DEF_ROWS 20
+#define DEF_COLS 10
+
+const char g_names[] = "IOTLJSZ"; 
+
+typedef struct REFERENCE
+{
+    const char *name; 
+    const char *board[8];   // bottom rows, top to bottom
+    const char *pieces; 
+    int depth; 
+    unsigned long long expected; 
+}REFERENCE; 
+
+const REFERENCE g_references[] = {
+    { "empty O", { NULL }, "O", 1, 9 }, 
+    { "empty I", { NULL }, "I", 1, 17 }, 
+    { "empty T", { NULL }, "T", 1, 34 }, 
+    { "empty S", { NULL }, "S", 1, 17 }, 
+    { "empty L", { NULL }, "L", 1, 34 }, 
+    { "empty TI", { NULL }, "TI", 2, 596 }, 
+    { "empty IOTL", { NULL }, "IOTL", 4, 188236 }, 
+    { "empty TLSZ", { NULL }, "TLSZ", 4, 384798 }, 
+    { "tuck", { "###.......", "###..#####", "##...#####" }, "TSZ", 3, 10651 }, 
+    { "tetris ready", { 
+        "#########.", 
+        "#########.", 
+        "#########.", 
+        "#########." }, "IJLO", 4, 194937 }, 
+    { "garbage", { 
+        ".#.#.#.#.#", 
+        "#.#.#.#.#.", 
+        "##.####.##", 
+        "#.######.#" }, "ZSTIO", 4, 184037 }, 
+}; 
+
+typedef struct PERFT
+{
+    int nrows, ncols; 
+    TMASK rots[TETROMINO_COUNT][4]; 
+    int pieces[64]; 
+    int npieces; 
+
+    // root split
+    BOARD_ROW root[BOARD_MAX_ROWS]; 
+    PLACEMENT moves[MAX_PLACEMENTS]; 
+    int nmoves; 
+    int depth; 
+    atomic_int next; 
+    atomic_ullong leaves; 
+    atomic_ullong nodes; 
+}PERFT; 
+
+double get_time()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + t.tv_nsec * 1e-9; 
+}
+
+unsigned long long perft(const PERFT *p, const BOARD_ROW *rows, int ply, int depth, 
+        unsigned long long *nodes)
+{
+    if(depth == 0) return 1; 
+
+    PLACEMENT moves[MAX_PLACEMENTS]; 
+    const TMASK *rots = p->rots[p->pieces[ply % p->npieces]]; 
+    int n = board_placements(rows, p->nrows, p->ncols, rots, moves); 
+    *nodes += n; 
+    if(depth == 1) return n; 
+
+    unsigned long long total = 0; 
+    BOARD_ROW next[BOARD_MAX_ROWS]; 
+    for(int i = 0; i < n; ++i)
+    {
+        memcpy(next, rows, p->nrows * sizeof(BOARD_ROW)); 
+        board_place(next, moves[i].t, moves[i].y, moves[i].x); 
+        board_clear_lines(next, p->nrows, p->ncols); 
+        total += perft(p, next, ply+1, depth-1, nodes); 
+    }
+    return total; 
+}
+
+void *root_worker(void *pargs)
+{
+    PERFT *p = (PERFT *) pargs; 
+    BOARD_ROW next[BOARD_MAX_ROWS]; 
+    int i; 
+    while((i = atomic_fetch_add(&p->next, 1)) < p->nmoves)
+    {
+        unsigned long long nodes = 0; 
+        memcpy(next, p->root, p->nrows * sizeof(BOARD_ROW)); 
+        board_place(next, p->moves[i].t, p->moves[i].y, p->moves[i].x); 
+        board_clear_lines(next, p->nrows, p->ncols); 
+        unsigned long long leaves = perft(p, next, 1, p->depth-1, &nodes); 
+        atomic_fetch_add(&p->leaves, leaves); 
+        atomic_fetch_add(&p->nodes, nodes); 
+    }
+    return NULL; 
+}
+
+unsigned long long run(PERFT *p, int threads, unsigned long long *nodes)
+{
+    if(p->depth == 0) 
+    {
+        *nodes = 0; 
+        return 1; 
+    }
+    p->nmoves = board_placements(p->root, p->nrows, p->ncols, 
+            p->rots[p->pieces[0]], p->moves); 
+    atomic_init(&p->next, 0); 
+    atomic_init(&p->leaves, 0); 
+    atomic_init(&p->nodes, p->nmoves); 
+    if(p->depth == 1)
+    {
+        *nodes = p->nmoves; 
+        return p->nmoves; 
+    }
+
+    pthread_t ids[threads]; 
+    for(int i = 1; i < threads; ++i)
+        pthread_create(&ids[i], NULL, root_worker, p); 
+    root_worker(p); 
+    for(int i = 1; i < threads; ++i)
+        pthread_join(ids[i], NULL); 
+
+    *nodes = atomic_load(&p->nodes); 
+    return atomic_load(&p->leaves); 
+}
+
+int set_pieces(PERFT *p, const char *pieces)
+{
+    p->npieces = 0; 
+    for(; *pieces && p->npieces < 64; ++pieces)
+    {
+        const char *c = strchr(g_names, *pieces); 
+        if(c == NULL) return 0; 
+        p->pieces[p->npieces++] = c - g_names; 
+    }
+    return p->npieces > 0; 
+}
+
+void set_row(PERFT *p, int r, const char *line)
+{
+    p->root[r] = 0; 
+    for(int j = 0; j < p->ncols && line[j] && line[j] != '\n'; ++j)
+        if(line[j] != '.' && line[j] != ' ')
+            p->root[r] |= 1u << j; 
+}
+
+int load_board(PERFT *p, const char *path)
+{
+    FILE *f = fopen(path, "r"); 
+    if(f == NULL) return 0; 
+    // one spare row and column so a board too big for the well is seen
+    char lines[BOARD_MAX_ROWS + 1][BOARD_MAX_COLS + 2]; 
+    int n = 0; 
+    while(n <= p->nrows && fgets(lines[n], sizeof(lines[n]), f))
+        ++n; 
+    fclose(f); 
+    if(n > p->nrows) return -1; 
+    for(int i = 0; i < n; ++i)
+        if(strcspn(lines[i], "\n") > (size_t)p->ncols) return -1; 
+
+    memset(p->root, 0, sizeof(p->root)); 
+    for(int i = 0; i < n; ++i)
+        set_row(p, p->nrows - n + i, lines[i]); 
+    return 1; 
+}
+
+void init(PERFT *p, int nrows, int ncols)
+{
+    memset(p, 0, sizeof(PERFT)); 
+    p->nrows = nrows; 
+    p->ncols = ncols; 
+    for(int i = 0; i < TETROMINO_COUNT; ++i)
+    {
+        TMASK t = get_mask_n(i); 
+        for(int r = 0; r < 4; ++r)
+        {
+            p->rots[i][r] = t; 
+            t = rotate_mask(t); 
+        }
+    }
+}
+
+int run_references(int threads)
+{
+    static PERFT p; 
+    int failed = 0; 
+    unsigned long long all_nodes = 0; 
+    double all_secs = 0; 
+    for(int i = 0; i < (int)(sizeof(g_references) / sizeof(g_references[0])); ++i)
+    {
+        const REFERENCE *ref = &g_references[i]; 
+        init(&p, DEF_ROWS, DEF_COLS); 
+        int n = 0; 
+        while(n < 8 && ref->board[n]) ++n; 
+        for(int r = 0; r < n; ++r)
+            set_row(&p, p.nrows - n + r, ref->board[r]); 
+        set_pieces(&p, ref->pieces); 
+        p.depth = ref->depth; 
+
+        unsigned long long nodes; 
+        double beg = get_time(); 
+        unsigned long long count = run(&p, threads, &nodes); 
+        double secs = get_time() - beg; 
+        all_nodes += nodes; 
+        all_secs += secs; 
+
+        int ok = count == ref->expected; 
+        failed += !ok; 
+        printf("%-14s %-6s depth %d: %12llu %s (%llu nodes, %.0f nodes/s)\n", 
+                ref->name, ref->pieces, ref->depth, count, 
+                ok ? "ok" : "FAILED", nodes, nodes / (secs > 0 ? secs : 1e-9)); 
+        if(!ok) 
+            printf("    expected %llu\n", ref->expected); 
+    }
+    printf("%d/%zu passed, %llu nodes in %.3fs, %.0f nodes/s\n", 
+            (int) (sizeof(g_references) / sizeof(g_references[0])) - failed, 
+            sizeof(g_references) / sizeof(g_references[0]), 
+            all_nodes, all_secs, all_nodes / (all_secs > 0 ? all_secs : 1e-9)); 
+    return failed; 
+}
+
+int main(int argc, char **argv)
+{
+    int depth = -1; 
+    int threads = 1; 
+    const char *pieces = "TIOLJSZ"; 
+    const char *board = NULL; 
+
+    int opt; 
+    while((opt = getopt(argc, argv, "d:p:b:j:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'd': depth = atoi(optarg); break; 
+            case 'p': pieces = optarg; break; 
+            case 'b': board = optarg; break; 
+            case 'j': threads = atoi(optarg); break; 
+            default: 
+                fprintf(stderr, "usage: %s [-d depth] [-p pieces] [-b board] [-j threads]\n", argv[0]); 
+                return 2; 
+        }
+    }
+    if(threads < 1) threads = 1; 
+
+    if(depth < 0) 
+        return run_references(threads) != 0; 
+
+    static PERFT p; 
+    init(&p, DEF_ROWS, DEF_COLS); 
+    if(!set_pieces(&p, pieces))
+    {
+        fprintf(stderr, "pieces must be from %s\n", g_names); 
+        return 2; 
+    }
+    int loaded = board != NULL ? load_board(&p, board) : 1; 
+    if(loaded == 0)
+    {
+        perror(board); 
+        return 2; 
+    }
+    if(loaded < 0)
+    {
+        fprintf(stderr, "%s: board must fit in %d rows of %d columns\n", board, p.nrows, p.ncols); 
+        return 2; 
+    }
+    p.depth = depth; 
+
+    unsigned long long nodes; 
+    double beg = get_time(); 
+    unsigned long long count = run(&p, threads, &nodes); 
+    double secs = get_time() - beg; 
+    printf("depth %d: %llu placements, %llu nodes in %.3fs, %.0f nodes/s\n", 
+            depth, count, nodes, secs, nodes / (secs > 0 ? secs : 1e-9)); 
+}
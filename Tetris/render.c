@@ -0,0 +1,62 @@
+#include "canvas.h"
+#include "render.h"
+
+static CANVAS *g_canvas; 
+static int g_rows, g_cols; 
+
+// cell (r, c) is drawn at (1 + r, 1 + 2*c)
+static void draw_cell(int r, int c, int color)
+{
+    chtype attr = color == RENDER_FLASH ? A_REVERSE : COLOR_PAIR(color); 
+    canvas_fill(g_canvas, 1 + r, 1 + 2*c, 1, 2, ' ' | attr); 
+}
+
+// the first flush repaints the whole window, border included
+void render_init(WINDOW *win, int rows, int cols)
+{
+    if(!g_canvas || canvas_win(g_canvas) != win)
+    {
+        canvas_destroy(g_canvas); 
+        g_canvas = canvas_create(win); 
+    }
+    g_rows = rows; 
+    g_cols = cols; 
+    canvas_clear(g_canvas); 
+    canvas_box(g_canvas); 
+    canvas_invalidate(g_canvas); 
+}
+
+// forget what is on screen so the next flush repaints every cell
+void render_invalidate()
+{
+    canvas_invalidate(g_canvas); 
+}
+
+void render_board(const unsigned char colors[][BOARD_MAX_COLS])
+{
+    for(int i = 0; i < g_rows; ++i)
+        for(int j = 0; j < g_cols; ++j)
+            draw_cell(i, j, colors[i][j]); 
+}
+
+void render_tetromino(TMASK t, int y, int x, int color)
+{
+    for(int i = 0; i < 4; ++i)
+        for(int j = 0; j < 4; ++j)
+            if(t & (1 << (4*i + j)) && y + i < g_rows && x + j < g_cols)
+                draw_cell(y + i, x + j, color); 
+}
+
+void render_rows(const int *rows, int n, int color)
+{
+    for(int i = 0; i < n; ++i)
+        for(int j = 0; j < g_cols; ++j)
+            draw_cell(rows[i], j, color); 
+}
+
+// copies the changes to the well's window, the caller ends the frame,
+// returns the cells that changed
+int render_flush()
+{
+    return canvas_flush(g_canvas); 
+}
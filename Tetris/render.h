@@ -0,0 +1,23 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <ncurses.h>
+
+#include "board.h"
+
+// Draws the well from the in-memory game state. 
+// Each frame is built in a back buffer and only the cells that differ from 
+// what is already on screen are sent to curses. 
+
+#define RENDER_FLASH 8
+
+void render_init(WINDOW *win, int rows, int cols); 
+void render_invalidate(); 
+
+void render_board(const unsigned char colors[][BOARD_MAX_COLS]); 
+void render_tetromino(TMASK t, int y, int x, int color); 
+void render_rows(const int *rows, int n, int color); 
+
+int render_flush(); 
+
+#endif
@@ -1,14 +1,27 @@
-#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-#include <sys/time.h>
 #include <ncurses.h>
 
+#include "arcade.h"
+#include "board.h"
+#include "canvas.h"
+#include "input.h"
+#include "prof.h"
+#include "render.h"
+#include "term.h"
 #include "tetromino.h"
 
-#define USEC_IN_SEC 0.000001
+// game loop period in seconds
+#define TICK 0.002
+
+// every key event moves once, a key is held while the terminal keeps repeating
+// it at least every HOLD_GAP and a hold that has lasted DAS also auto shifts
+// whenever ARR passes without a move
+#define DAS 0.100
+#define ARR 0.030
+#define HOLD_GAP 0.100
 
 #define CONTINUE 0
 #define RESTART 1
@@ -16,47 +29,79 @@
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
 
-const char title[] = "Tetris"; 
+const char tetris_title[] = "Tetris"; 
 
 WINDOW *g_main_win; 
 WINDOW *g_game_win; 
 WINDOW *g_score_win; 
 WINDOW *g_next_win; 
 
-void setup(); 
-
-int play(); 
-int play_again(); 
+// the well is render.c's, the other windows are drawn whole every frame
+CANVAS *g_main_canvas, *g_score_canvas, *g_next_canvas; 
 
-void cleanup(); 
+// the well, cell (r, c) is drawn at (1 + r, 1 + 2*c) in g_game_win
+int g_rows, g_cols; 
+BOARD_ROW g_board[BOARD_MAX_ROWS]; 
+unsigned char g_colors[BOARD_MAX_ROWS][BOARD_MAX_COLS]; 
 
-int main()
+typedef struct KEY_STATE
 {
-    setup(); 
-    srand(time(0)); 
-    int status; 
-    do
-    {
-        status = play(); 
-        if(status == QUIT) break; 
-    }
-    while(status == RESTART || play_again()); 
-    cleanup(); 
-}
-
-double get_time()
+    double pressed;     // start of the current hold
+    double last;        // last event for this key
+    double shifted;     // last move, by an event or an auto shift
+}KEY_STATE; 
+
+KEY_STATE g_left, g_right, g_down; 
+
+// the piece falling, g_rotated is it turned once, and the one after it
+int g_piece, g_next_piece; 
+int **g_tetromino, **g_rotated, **g_next; 
+int g_sy, g_sx; 
+double g_cycle_start;   // start of the current step down
+double g_tick;          // start of the last tick
+int g_score; 
+
+// keys handled since the last frame
+double g_times[64]; 
+int g_ntimes; 
+
+// time from a key reaching the input thread to the frame that shows it
+long g_latency_n; 
+double g_latency_sum, g_latency_max; 
+
+void tetris_init(); 
+void tetris_start(); 
+int tetris_tick(); 
+int tetris_render(); 
+void tetris_shutdown(); 
+
+void new_game(); 
+void end_game(); 
+int land_piece(); 
+int play_again(); 
+void tetris_print_latency(FILE *f); 
+
+const ARCADE_GAME tetris_game = {
+    "Tetris", 
+    tetris_init, 
+    tetris_start, 
+    tetris_tick, 
+    tetris_render, 
+    tetris_shutdown
+}; 
+
+#ifndef NARCADE_LAUNCHER
+int main()
 {
-    struct timeval t; 
-    gettimeofday(&t, NULL); 
-    return t.tv_sec + t.tv_usec * USEC_IN_SEC; 
+    srand(prof_seed()); 
+    arcade_main(&tetris_game); 
+    tetris_print_latency(stdout); 
 }
+#endif
 
-WINDOW *gen_win(int h, int w, int y, int x)
+static double get_time()
 {
-    WINDOW *win = newwin(h, w, y, x); 
-    box(win, 0, 0); 
-    wrefresh(win); 
-    return win; 
+    return input_time(); 
 }
 
 void gen_wins() 
@@ -65,11 +110,11 @@ void gen_wins()
     int main_width = main_height * 4; 
     int main_starty = (LINES - main_height) / 2; 
     int main_startx = (COLS - main_width) / 2; 
-    g_main_win = gen_win(main_height, main_width, main_starty, main_startx); 
+    g_main_win = newwin(main_height, main_width, main_starty, main_startx); 
 
     int game_width = main_width * 0.3; 
     int game_startx = main_startx + (main_width - game_width) / 2; 
-    g_game_win = gen_win(main_height, game_width, main_starty, game_startx); 
+    g_game_win = newwin(main_height, game_width, main_starty, game_startx); 
 
     int score_height = main_height * 0.15; 
     int next_height = main_height * 0.35; 
@@ -84,8 +129,8 @@ void gen_wins()
     int score_startx = game_startx + game_width 
         + ((main_width - game_width) / 2 - score_width) / 2; 
     
-    g_score_win = gen_win(score_height, score_width, score_starty, score_startx); 
-    g_next_win = gen_win(next_height, score_width, next_starty, score_startx); 
+    g_score_win = newwin(score_height, score_width, score_starty, score_startx); 
+    g_next_win = newwin(next_height, score_width, next_starty, score_startx); 
 }
 
 void print_title(WINDOW *win, const char *title)
@@ -96,33 +141,33 @@ void print_title(WINDOW *win, const char *title)
     mvprintw(y-1, x + (w-strlen(title)) / 2, "%s", title); 
 }
 
-void print_titles()
+// the side windows lie on the main window, their titles go in its canvas
+void print_side_title(WINDOW *win, const char *title)
 {
-    print_title(g_main_win, title); 
-    print_title(g_score_win, "Score");  
-    print_title(g_next_win, "Next"); 
+    int y = getbegy(win) - getbegy(g_main_win) - 1; 
+    int x = getbegx(win) - getbegx(g_main_win) + (getmaxx(win) - (int) strlen(title)) / 2; 
+    canvas_print(g_main_canvas, y, x, A_NORMAL, title); 
 }
 
-void reset_win(WINDOW *w)
+// the next frame repaints every window
+void invalidate_wins()
 {
-    werase(w); 
-    box(w, 0, 0); 
-    wrefresh(w); 
+    canvas_invalidate(g_main_canvas); 
+    canvas_invalidate(g_score_canvas); 
+    canvas_invalidate(g_next_canvas); 
+    render_invalidate(); 
 }
 
-void reset_wins()
+// puts back what the frame time overlay covered
+void redraw_wins()
 {
-    reset_win(g_main_win); 
-    reset_win(g_game_win); 
-    reset_win(g_score_win); 
-    reset_win(g_next_win); 
+    touchwin(stdscr); 
+    wnoutrefresh(stdscr); 
+    invalidate_wins(); 
 }
 
 void setup_color()
 {
-    start_color(); 
-    use_default_colors(); 
-
     init_pair(1, -1, 51);   // I, cyan 
     init_pair(2, -1, 226);  // O, yellow
     init_pair(3, -1, 201);  // T, magenta
@@ -132,32 +177,29 @@ void setup_color()
     init_pair(7, -1, 196);  // Z, red
 }
 
-void setup()
+void tetris_init()
 {
-    initscr(); 
-    printw("Press Space to options"); 
-    refresh(); 
-    cbreak(); 
-    noecho(); 
-    curs_set(0); 
-
     gen_wins(); 
-    print_titles(); 
-    refresh(); 
+    g_main_canvas = canvas_create(g_main_win); 
+    canvas_box(g_main_canvas); 
+    print_side_title(g_score_win, "Score"); 
+    print_side_title(g_next_win, "Next"); 
+    g_score_canvas = canvas_create(g_score_win); 
+    g_next_canvas = canvas_create(g_next_win); 
     keypad(g_game_win, TRUE); 
     nodelay(g_game_win, TRUE); 
 
     if(has_colors()) setup_color(); 
 }
 
-void redraw(WINDOW *w)
+void tetris_start()
 {
-    for(int i = 0; i < getmaxy(w); ++i)
-        for(int j = 0; j < getmaxx(w); ++j)
-        {
-            chtype ch = mvwinch(w, i, j); 
-            waddch(w, ch); 
-        }
+    erase(); 
+    printw("Press Space to options, P for frame times"); 
+    print_title(g_main_win, tetris_title); 
+    // shown with the first frame
+    wnoutrefresh(stdscr); 
+    new_game(); 
 }
 
 int show_propmt(const char *prompt, char **opts, int n)
@@ -178,7 +220,8 @@ int show_propmt(const char *prompt, char **opts, int n)
         int x = (width - strlen(opts[i])) / 2; 
         mvwprintw(w, y, x, opts[i]);  
     }
-    wrefresh(w); 
+    wnoutrefresh(w); 
+    term_frame(); 
 
     int ch = 0; 
     int i = 0; 
@@ -190,11 +233,13 @@ int show_propmt(const char *prompt, char **opts, int n)
         else if(ch == KEY_DOWN && i < n-1)  ++i; 
         mvwchgat(w, pady + i, 1, 
                 width - 2, A_REVERSE, 0, NULL); 
-        wrefresh(w); 
+        wnoutrefresh(w); 
+        term_frame(); 
     } while((ch = wgetch(w)) != 10); 
 
+    // goes with the next frame, which repaints the well under it
     werase(w); 
-    wrefresh(w); 
+    wnoutrefresh(w); 
     delwin(w); 
     return i; 
 }
@@ -210,143 +255,254 @@ int pause()
     return show_propmt(prompt, opts, ARRAY_SIZE(opts)); 
 }
 
-void draw_tetromino(WINDOW *win, chtype ch, TETROMINO t, int sy, int sx)
+void draw_tetromino(CANVAS *c, chtype ch, TETROMINO t, int sy, int sx)
 {
     for(int i = 0; i < 4; ++i)
         for(int j = 0; j < 4; ++j)
             if(t[i][j])
-                mvwhline(win, sy + i, sx + 2*j, ch, 2); 
+                canvas_fill(c, sy + i, sx + 2*j, 1, 2, ch); 
+}
+
+void draw_score()
+{
+    char text[16]; 
+    snprintf(text, sizeof(text), "%d", g_score); 
+    canvas_clear(g_score_canvas); 
+    canvas_box(g_score_canvas); 
+    canvas_print(g_score_canvas, getmaxy(g_score_win) / 2, 
+            (getmaxx(g_score_win) - (int) strlen(text)) / 2, A_NORMAL, text); 
 }
 
-int is_valid(const WINDOW *win, int y, int x)
+void draw_next()
 {
-    return 0 < y && y < getmaxy(win)-1 
-        && 0 < x && x < getmaxx(win)-2; 
+    canvas_clear(g_next_canvas); 
+    canvas_box(g_next_canvas); 
+    if(!g_next) return; 
+    int sy = (getmaxy(g_next_win) - get_height(g_next)) / 2; 
+    int sx = (getmaxx(g_next_win) - 2*get_width(g_next)) / 2; 
+    draw_tetromino(g_next_canvas, ' ' | COLOR_PAIR(g_next_piece+1), g_next, sy, sx); 
+}
+
+// sends every window that changed in one update, the main window first since
+// the others lie on it, returns the cells that changed
+int flush_frame()
+{
+    draw_score(); 
+    draw_next(); 
+    int changed = canvas_flush(g_main_canvas); 
+    changed += canvas_flush(g_score_canvas); 
+    changed += canvas_flush(g_next_canvas); 
+    changed += render_flush(); 
+    if(changed) term_frame(); 
+    return changed; 
 }
 
 int can_move(TETROMINO t, int y, int x)
 {
+    return board_fits(g_board, g_rows, g_cols, get_mask(t), y, x); 
+}
+
+// returns true if anything changed
+int draw_frame(int color, TETROMINO t, int y, int x)
+{
+    render_board(g_colors); 
+    render_tetromino(get_mask(t), y, x, color); 
+    return flush_frame(); 
+}
+
+void lock_tetromino(int color, TETROMINO t, int y, int x)
+{
+    TMASK mask = get_mask(t); 
+    board_place(g_board, mask, y, x); 
     for(int i = 0; i < 4; ++i)
-    {
         for(int j = 0; j < 4; ++j)
-        {
-            chtype ch = mvwinch(g_game_win, y + i, x + 2*j); 
-            int color = ch & A_COLOR; 
-            int valid = is_valid(g_game_win, y + i, x + 2*j); 
+            if(mask & (1 << (4*i + j)))
+                g_colors[y+i][x+j] = color; 
+}
 
-            if(t[i][j] && (color != COLOR_PAIR(0) || !valid))
-                return false; 
-        }
-    }
+// records an event for the key, which moves the piece as well
+void press(KEY_STATE *k, double time)
+{
+    if(time - k->last > HOLD_GAP)
+        k->pressed = time; 
+    k->last = k->shifted = time; 
+}
+
+int is_held(const KEY_STATE *k, double now)
+{
+    return now - k->last <= HOLD_GAP && k->last > k->pressed; 
+}
+
+// moves sideways while a key is held, at most once per call, only after the
+// repeats themselves have gone on for DAS so quick taps never shift
+int auto_shift(KEY_STATE *k, double now)
+{
+    if(!is_held(k, now) || k->last - k->pressed < DAS || now - k->shifted < ARR) 
+        return false; 
+    k->shifted = now; 
     return true; 
 }
 
-// t is a ptr to a tetromino (aka a 2D array)
-int drop_tetromino(int i, TETROMINO * t)
-{   
-    int w = getmaxx(g_game_win); 
-    double drop_rate = 0.5; // one line per sec
+void release_keys()
+{
+    memset(&g_left, 0, sizeof(KEY_STATE)); 
+    memset(&g_right, 0, sizeof(KEY_STATE)); 
+    memset(&g_down, 0, sizeof(KEY_STATE)); 
+}
 
-    int ch; 
+void record_latency(const double *times, int n, double frame)
+{
+    for(int k = 0; k < n; ++k)
+    {
+        double latency = frame - times[k]; 
+        g_latency_sum += latency; 
+        if(latency > g_latency_max) g_latency_max = latency; 
+    }
+    g_latency_n += n; 
+}
 
-    int sy = 1;
-    int sx = (w - 4) / 2;
-    int **rot = rotate(*t); 
+void sleep_tick(double since)
+{
+    double left = TICK - (get_time() - since); 
+    if(left <= 0) return; 
+    struct timespec ts = { 0, (long) (left * 1e9) }; 
+    nanosleep(&ts, NULL); 
+}
 
+// Runs once every TICK, the rest of the time belongs to the input thread. 
+int tetris_tick()
+{   
+    double drop_rate = 0.5; // one line per sec
     double drop_factor; 
-    double cycle_start = get_time(); 
 
-    while(true)
+    sleep_tick(g_tick); 
+    double now = get_time(); 
+    g_tick = now; 
+
+    // apply every key that arrived since the last tick, in order 
+    INPUT_EVENT ev; 
+    prof_begin(PROF_INPUT); 
+    while(input_poll(&ev))
     {
-        ch = wgetch(g_game_win); 
-        draw_tetromino(g_game_win, ' ' | COLOR_PAIR(0), *t, sy, sx); 
-
-        drop_factor = 1; 
-        if(ch == KEY_LEFT && can_move(*t, sy, sx-2))
-            sx -= 2; 
-        else if(ch == KEY_RIGHT && can_move(*t, sy, sx+2)) 
-            sx += 2; 
-        else if(ch == KEY_UP && can_move(rot, sy, sx))
+        if(g_ntimes < (int)ARRAY_SIZE(g_times)) g_times[g_ntimes++] = ev.time; 
+
+        if(ev.key == KEY_LEFT)
+        {
+            press(&g_left, ev.time); 
+            if(can_move(g_tetromino, g_sy, g_sx-1)) --g_sx; 
+        }
+        else if(ev.key == KEY_RIGHT)
+        {
+            press(&g_right, ev.time); 
+            if(can_move(g_tetromino, g_sy, g_sx+1)) ++g_sx; 
+        }
+        else if(ev.key == KEY_UP && can_move(g_rotated, g_sy, g_sx))
         {
             // address of array changes
-            del_copy(*t); 
-            *t = rot; 
-            rot = rotate(*t); 
+            del_copy(g_tetromino); 
+            g_tetromino = g_rotated; 
+            g_rotated = rotate(g_tetromino); 
+        }
+        else if(ev.key == KEY_DOWN)
+        {
+            press(&g_down, ev.time); 
+            if(can_move(g_tetromino, g_sy+1, g_sx))
+            {
+                ++g_sy; 
+                g_cycle_start = ev.time; 
+            }
+        }
+        else if(ev.key == 'p' || ev.key == 'P')
+        {
+            if(!prof_toggle_overlay()) redraw_wins(); 
         }
-        else if(ch == KEY_DOWN)
-            drop_factor = 0.1;  
-        else if(ch == ' ')
+        else if(ev.key == ' ')
         {
+            // time spent paused is not part of any frame
+            prof_end(PROF_INPUT); 
+            input_stop(); 
             int status = pause(); 
-            if(status == 0)
+            release_keys(); 
+            g_ntimes = 0; 
+            if(status == QUIT)
             {
-                redraw(g_game_win); 
-                wrefresh(g_game_win); 
+                end_game(); 
+                return 0; 
             }
-            else
+            if(status == RESTART)
             {
-                del_copy(rot); 
-                return status; 
+                end_game(); 
+                new_game(); 
+                return 1; 
             }
+            input_start(); 
+            // the next frame covers the prompt
+            render_invalidate(); 
+            now = get_time(); 
+            prof_begin(PROF_INPUT); 
         }
-
-        if(get_time() - cycle_start >= drop_rate * drop_factor) 
-        {
-            if(can_move(*t, sy+1, sx)) ++sy;  
-            else                      break; 
-            cycle_start = get_time(); 
-        }
-
-        draw_tetromino(g_game_win, ' ' | COLOR_PAIR(i+1), *t, sy, sx); 
-        wrefresh(g_game_win); 
     }
 
-    del_copy(rot); 
-    draw_tetromino(g_game_win, ' ' | COLOR_PAIR(i+1), *t, sy, sx); 
-    wrefresh(g_game_win); 
-
-    return CONTINUE; 
-}
+    prof_end(PROF_INPUT); 
 
-void clear_line(int n)
-{
-    for(int i = n; i > 0; --i)
+    int landed = 0; 
+    PROF_SCOPE(PROF_SIM)
     {
-        int finished = true; 
-        for(int j = 1; j < getmaxx(g_game_win)-1; ++j)
+        if(auto_shift(&g_left, now) && can_move(g_tetromino, g_sy, g_sx-1)) 
+            --g_sx; 
+        if(auto_shift(&g_right, now) && can_move(g_tetromino, g_sy, g_sx+1)) 
+            ++g_sx; 
+
+        drop_factor = is_held(&g_down, now) ? 0.1 : 1; 
+        if(now - g_cycle_start >= drop_rate * drop_factor) 
         {
-            chtype tmp = mvwinch(g_game_win, i-1, j); 
-            mvwaddch(g_game_win, i, j, tmp); 
-            finished = finished && (tmp & A_COLOR) == COLOR_PAIR(0); 
+            if(can_move(g_tetromino, g_sy+1, g_sx)) ++g_sy;  
+            else                                    landed = 1; 
+            g_cycle_start = now; 
         }
-        if(finished) break; 
     }
+    return landed ? land_piece() : 1; 
+}
+
+// returns true if anything changed
+int tetris_render()
+{
+    int drawn = draw_frame(g_piece+1, g_tetromino, g_sy, g_sx); 
+    if(g_ntimes) record_latency(g_times, g_ntimes, get_time()); 
+    g_ntimes = 0; 
+    return drawn; 
 }
 
 int clear_lines()
 {
-    int cols = (int) (getmaxx(g_game_win) / 2) - 1; 
+    int full[4]; 
     int cleared = 0; 
-    int i = getmaxy(g_game_win) - 2; 
-    while(i > 1) 
+    for(int i = 0; i < g_rows; ++i)
+        if(board_is_full(g_board[i], g_cols) && cleared < 4)
+            full[cleared++] = i; 
+    if(!cleared) return 0; 
+
+    // flash the full rows then shift everything above them down 
+    render_rows(full, cleared, RENDER_FLASH); 
+    flush_frame(); 
+    napms(100); 
+
+    int dst = g_rows - 1; 
+    for(int src = g_rows - 1; src >= 0; --src)
     {
-        int full = true, empty = true; 
-        for(int j = 0; j < cols; ++j)
-        {
-            chtype ch = mvwinch(g_game_win, i, 2*j+1); 
-            int color = ch & A_COLOR; 
-            full = full && color != COLOR_PAIR(0); 
-            empty = empty && color == COLOR_PAIR(0); 
-        }
-        if(full)        
-        {
-            clear_line(i); 
-            ++cleared; 
-        }
-        else if(empty)  break; 
-        else            --i; 
+        if(board_is_full(g_board[src], g_cols)) continue; 
+        g_board[dst] = g_board[src]; 
+        memmove(g_colors[dst], g_colors[src], g_cols); 
+        --dst; 
     }
-    wrefresh(g_game_win); 
+    for(; dst >= 0; --dst)
+    {
+        g_board[dst] = 0; 
+        memset(g_colors[dst], 0, g_cols); 
+    }
+
+    render_board(g_colors); 
+    flush_frame(); 
     return cleared; 
 }
 
@@ -369,68 +525,84 @@ int calc_score(int n)
 
 int game_over()
 {
-    int cols = (int) (getmaxx(g_game_win) / 2) - 1; 
-    for(int j = 0; j < cols; ++j)
-    {
-        chtype ch = mvwinch(g_game_win, 1, 2*j+1); 
-        int color = ch & A_COLOR; 
-        if(color != COLOR_PAIR(0))
-            return true; 
-    }
-    return false; 
+    return g_board[0] != 0; 
+}
+
+void reset_board()
+{
+    g_rows = getmaxy(g_game_win) - 2; 
+    g_cols = (getmaxx(g_game_win) - 2) / 2; 
+    if(g_rows > BOARD_MAX_ROWS) g_rows = BOARD_MAX_ROWS; 
+    if(g_cols > BOARD_MAX_COLS) g_cols = BOARD_MAX_COLS; 
+    memset(g_board, 0, sizeof(g_board)); 
+    memset(g_colors, 0, sizeof(g_colors)); 
+    render_init(g_game_win, g_rows, g_cols); 
 }
 
-int play()
+// shows the next piece and starts the one that was shown at the top
+void next_piece()
 {
-    reset_wins(); 
+    g_piece = g_next_piece; 
+    g_tetromino = g_next; 
+
+    // get and show next tetromino
+    g_next_piece = rand() % 7; 
+    g_next = get_copy(g_next_piece); 
+
+    g_sy = 0; 
+    g_sx = (g_cols - 4) / 2; 
+    g_rotated = rotate(g_tetromino); 
+    g_cycle_start = get_time(); 
+}
+
+void new_game()
+{
+    reset_board(); 
+    invalidate_wins(); 
+    release_keys(); 
+    input_start(); 
 
     // initialize game variables
-    int score = 0; 
-    mvwprintw(g_score_win, 
-            (getmaxy(g_score_win)-1) / 2, 
-            (getmaxx(g_score_win)-1) / 2, 
-            "%d", score); 
-    wrefresh(g_score_win); 
-    int i; 
-    int **tetromino; 
-    int ni = rand() % 7; 
-    int **n_tetromino = get_copy(ni); 
-
-    while(true)
+    g_score = 0; 
+    g_next_piece = rand() % 7; 
+    g_next = get_copy(g_next_piece); 
+    next_piece(); 
+    g_tick = get_time(); 
+}
+
+// delete game variables 
+void end_game()
+{
+    if(g_tetromino) del_copy(g_tetromino); 
+    if(g_rotated) del_copy(g_rotated); 
+    if(g_next) del_copy(g_next); 
+    g_tetromino = g_rotated = g_next = NULL; 
+    input_stop(); 
+}
+
+// locks the piece and brings in the next, returns 0 if the game is over and
+// the player does not want another
+int land_piece()
+{
+    del_copy(g_rotated); 
+    lock_tetromino(g_piece+1, g_tetromino, g_sy, g_sx); 
+    del_copy(g_tetromino); 
+    g_tetromino = g_rotated = NULL; 
+    render_board(g_colors); 
+    flush_frame(); 
+
+    if(game_over())
     {
-        i = ni; 
-        tetromino = n_tetromino; 
-
-        // get and show next tetromino
-        ni = rand() % 7; 
-        n_tetromino = get_copy(ni); 
-        werase(g_next_win); 
-        box(g_next_win, 0, 0); 
-        int n_sy = (getmaxy(g_next_win) - get_height(n_tetromino)) / 2; 
-        int n_sx = (getmaxx(g_next_win) - 2*get_width(n_tetromino)) / 2; 
-        draw_tetromino(g_next_win, ' ' | COLOR_PAIR(ni+1), n_tetromino, n_sy, n_sx);  
-        wrefresh(g_next_win); 
-
-        // play
-        int status = drop_tetromino(i, &tetromino); 
-        del_copy(tetromino); 
-        if(status != CONTINUE) return status; 
-
-        // update score
-        if(!game_over())
-            score += calc_score(clear_lines()); 
-        else break;  
-        int digits = ceil(log10(score)); 
-        mvwprintw(g_score_win, 
-                getmaxy(g_score_win) / 2, 
-                (getmaxx(g_score_win) - digits) / 2, 
-                "%d", score); 
-        wrefresh(g_score_win); 
+        end_game(); 
+        if(!play_again()) return 0; 
+        new_game(); 
+        return 1; 
     }
 
-    // delete game variables 
-    del_copy(n_tetromino); 
-    return CONTINUE; 
+    // update score
+    g_score += calc_score(clear_lines()); 
+    next_piece(); 
+    return 1; 
 }
 
 int play_again()
@@ -448,8 +620,17 @@ void del_wins()
     delwin(g_next_win); 
 }
 
-void cleanup()
+void tetris_shutdown()
 {
+    canvas_destroy(g_main_canvas); 
+    canvas_destroy(g_score_canvas); 
+    canvas_destroy(g_next_canvas); 
     del_wins(); 
-    endwin(); 
+}
+
+void tetris_print_latency(FILE *f)
+{
+    if(g_latency_n)
+        fprintf(f, "input to frame latency: %ld keys, avg %.2f ms, max %.2f ms\n", 
+                g_latency_n, g_latency_sum / g_latency_n * 1000, g_latency_max * 1000); 
 }
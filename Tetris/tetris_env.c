@@ -0,0 +1,283 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include "board.h"
+#include "tetris_env.h"
+
+struct TENV
+{
+    int n; 
+
+    // structure of arrays, one entry per game
+    BOARD_ROW *rows;        // n * TENV_ROWS
+    unsigned char *piece; 
+    unsigned char *next; 
+    unsigned char *rot; 
+    signed char *y, *x; 
+    unsigned char *ticks; 
+    unsigned int *rng; 
+
+    TMASK masks[TETROMINO_COUNT][4]; 
+    signed char widths[TETROMINO_COUNT][4]; 
+
+    // worker pool, the calling thread steps the first slice
+    int threads; 
+    pthread_t *workers; 
+    pthread_barrier_t start, done; 
+    int quit; 
+    const unsigned char *actions; 
+    unsigned char *obs; 
+    float *rewards; 
+    unsigned char *dones; 
+}; 
+
+typedef struct WORKER_ARGS
+{
+    TENV *env; 
+    int id; 
+}WORKER_ARGS; 
+
+static const float g_line_rewards[] = { 0, 40, 100, 300, 1200 }; 
+
+static unsigned int next_rand(unsigned int *state)
+{
+    // xorshift32
+    unsigned int s = *state; 
+    s ^= s << 13; 
+    s ^= s >> 17; 
+    s ^= s << 5; 
+    return *state = s; 
+}
+
+// returns false if the new piece does not fit (top out)
+static int spawn(TENV *env, int e)
+{
+    int p = env->next[e]; 
+    env->piece[e] = p; 
+    env->next[e] = next_rand(&env->rng[e]) % TETROMINO_COUNT; 
+    env->rot[e] = 0; 
+    env->y[e] = 0; 
+    env->x[e] = (TENV_COLS - env->widths[p][0]) / 2; 
+    env->ticks[e] = 0; 
+    return board_fits(env->rows + e * TENV_ROWS, TENV_ROWS, TENV_COLS, 
+            env->masks[p][0], 0, env->x[e]); 
+}
+
+static void reset_one(TENV *env, int e)
+{
+    memset(env->rows + e * TENV_ROWS, 0, TENV_ROWS * sizeof(BOARD_ROW)); 
+    env->next[e] = next_rand(&env->rng[e]) % TETROMINO_COUNT; 
+    spawn(env, e); 
+}
+
+static void write_obs(const TENV *env, int e, unsigned char *obs)
+{
+    const BOARD_ROW *rows = env->rows + e * TENV_ROWS; 
+    for(int i = 0; i < TENV_ROWS; ++i)
+        for(int j = 0; j < TENV_COLS; ++j)
+            obs[i * TENV_COLS + j] = (rows[i] >> j) & 1; 
+
+    TMASK t = env->masks[env->piece[e]][env->rot[e]]; 
+    for(int i = 0; i < 4; ++i)
+        for(int j = 0; j < 4; ++j)
+            if(t & (1 << (4*i + j)))
+                obs[(env->y[e] + i) * TENV_COLS + env->x[e] + j] = TENV_FALLING; 
+
+    obs[TENV_ROWS * TENV_COLS] = env->piece[e]; 
+    obs[TENV_ROWS * TENV_COLS + 1] = env->next[e]; 
+}
+
+static float step_one(TENV *env, int e, unsigned char action, unsigned char *done)
+{
+    BOARD_ROW *rows = env->rows + e * TENV_ROWS; 
+    int p = env->piece[e]; 
+    int r = env->rot[e]; 
+    int y = env->y[e], x = env->x[e]; 
+    TMASK t = env->masks[p][r]; 
+    int fall = ++env->ticks[e] >= TENV_GRAVITY; 
+
+    switch(action)
+    {
+        case TENV_LEFT: 
+            if(board_fits(rows, TENV_ROWS, TENV_COLS, t, y, x-1)) --x; 
+            break; 
+        case TENV_RIGHT: 
+            if(board_fits(rows, TENV_ROWS, TENV_COLS, t, y, x+1)) ++x; 
+            break; 
+        case TENV_ROTATE: 
+        {
+            int nr = (r + 1) & 3; 
+            if(board_fits(rows, TENV_ROWS, TENV_COLS, env->masks[p][nr], y, x))
+            {
+                r = nr; 
+                t = env->masks[p][nr]; 
+            }
+            break; 
+        }
+        case TENV_DOWN: 
+            fall = 1; 
+            break; 
+        case TENV_DROP: 
+            y = board_drop(rows, TENV_ROWS, TENV_COLS, t, y, x); 
+            fall = 1; 
+            break; 
+    }
+
+    env->rot[e] = r; 
+    env->x[e] = x; 
+    env->y[e] = y; 
+    *done = 0; 
+    if(!fall) return 0; 
+
+    env->ticks[e] = 0; 
+    if(board_fits(rows, TENV_ROWS, TENV_COLS, t, y+1, x))
+    {
+        env->y[e] = y + 1; 
+        return 0; 
+    }
+
+    // lock in place
+    board_place(rows, t, y, x); 
+    float reward = g_line_rewards[board_clear_lines(rows, TENV_ROWS, TENV_COLS)]; 
+    if(!spawn(env, e))
+    {
+        *done = 1; 
+        reset_one(env, e); 
+    }
+    return reward; 
+}
+
+static void step_slice(TENV *env, int id)
+{
+    int per = (env->n + env->threads - 1) / env->threads; 
+    int beg = id * per; 
+    int end = beg + per < env->n ? beg + per : env->n; 
+    for(int e = beg; e < end; ++e)
+    {
+        env->rewards[e] = step_one(env, e, env->actions[e], &env->dones[e]); 
+        write_obs(env, e, env->obs + (size_t) e * TENV_OBS_SIZE); 
+    }
+}
+
+static void *worker(void *pargs)
+{
+    WORKER_ARGS *args = (WORKER_ARGS *) pargs; 
+    TENV *env = args->env; 
+    int id = args->id; 
+    free(args); 
+
+    while(1)
+    {
+        pthread_barrier_wait(&env->start); 
+        if(env->quit) break; 
+        step_slice(env, id); 
+        pthread_barrier_wait(&env->done); 
+    }
+    return NULL; 
+}
+
+TENV *tenv_create(int n, int threads, unsigned int seed)
+{
+    TENV *env = (TENV *) calloc(1, sizeof(TENV)); 
+    env->n = n; 
+    env->rows = (BOARD_ROW *) calloc((size_t) n * TENV_ROWS, sizeof(BOARD_ROW)); 
+    env->piece = (unsigned char *) calloc(n, 1); 
+    env->next = (unsigned char *) calloc(n, 1); 
+    env->rot = (unsigned char *) calloc(n, 1); 
+    env->y = (signed char *) calloc(n, 1); 
+    env->x = (signed char *) calloc(n, 1); 
+    env->ticks = (unsigned char *) calloc(n, 1); 
+    env->rng = (unsigned int *) calloc(n, sizeof(unsigned int)); 
+
+    for(int p = 0; p < TETROMINO_COUNT; ++p)
+    {
+        TMASK t = get_mask_n(p); 
+        for(int r = 0; r < 4; ++r)
+        {
+            env->masks[p][r] = t; 
+            env->widths[p][r] = mask_width(t); 
+            t = rotate_mask(t); 
+        }
+    }
+
+    for(int e = 0; e < n; ++e)
+    {
+        // xorshift must not start at 0
+        env->rng[e] = (seed + e) * 2654435761u | 1; 
+        reset_one(env, e); 
+    }
+
+    env->threads = threads > 1 ? threads : 1; 
+    if(env->threads > n) env->threads = n > 0 ? n : 1; 
+    if(env->threads > 1)
+    {
+        pthread_barrier_init(&env->start, NULL, env->threads); 
+        pthread_barrier_init(&env->done, NULL, env->threads); 
+        env->workers = (pthread_t *) calloc(env->threads, sizeof(pthread_t)); 
+        for(int i = 1; i < env->threads; ++i)
+        {
+            WORKER_ARGS *args = (WORKER_ARGS *) malloc(sizeof(WORKER_ARGS)); 
+            args->env = env; 
+            args->id = i; 
+            pthread_create(&env->workers[i], NULL, worker, args); 
+        }
+    }
+    return env; 
+}
+
+void tenv_destroy(TENV *env)
+{
+    if(env->threads > 1)
+    {
+        env->quit = 1; 
+        pthread_barrier_wait(&env->start); 
+        for(int i = 1; i < env->threads; ++i)
+            pthread_join(env->workers[i], NULL); 
+        pthread_barrier_destroy(&env->start); 
+        pthread_barrier_destroy(&env->done); 
+        free(env->workers); 
+    }
+    free(env->rows); 
+    free(env->piece); 
+    free(env->next); 
+    free(env->rot); 
+    free(env->y); 
+    free(env->x); 
+    free(env->ticks); 
+    free(env->rng); 
+    free(env); 
+}
+
+int tenv_size(const TENV *env)
+{
+    return env->n; 
+}
+
+void tenv_reset(TENV *env, unsigned char *obs)
+{
+    for(int e = 0; e < env->n; ++e)
+    {
+        reset_one(env, e); 
+        write_obs(env, e, obs + (size_t) e * TENV_OBS_SIZE); 
+    }
+}
+
+void tenv_step(TENV *env, const unsigned char *actions, 
+        unsigned char *obs, float *rewards, unsigned char *dones)
+{
+    env->actions = actions; 
+    env->obs = obs; 
+    env->rewards = rewards; 
+    env->dones = dones; 
+
+    if(env->threads > 1)
+    {
+        // the barriers publish the arguments to the workers and their results back
+        pthread_barrier_wait(&env->start); 
+        step_slice(env, 0); 
+        pthread_barrier_wait(&env->done); 
+    }
+    else step_slice(env, 0); 
+}
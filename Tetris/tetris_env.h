@@ -0,0 +1,49 @@
+#ifndef TETRIS_ENV_H
+#define TETRIS_ENV_H
+
+// Batched Tetris for reinforcement learning. 
+// 
+// A TENV steps n independent games in lockstep. Every buffer passed to 
+// tenv_reset() and tenv_step() is owned by the caller and indexed by game: 
+//     actions[n], obs[n * TENV_OBS_SIZE], rewards[n], dones[n]
+// Games that top out are reset in the same step, their dones entry is set 
+// and obs already holds the first frame of the new game. 
+// Nothing is allocated after tenv_create(). 
+
+#define TENV_ROWS 20
+#define TENV_COLS 10
+
+// every TENV_GRAVITY steps the falling piece moves down one row
+#define TENV_GRAVITY 2
+
+// one byte per cell (0 empty, 1 locked, 2 falling) then the current and next piece
+#define TENV_OBS_SIZE (TENV_ROWS * TENV_COLS + 2)
+
+#define TENV_EMPTY 0
+#define TENV_LOCKED 1
+#define TENV_FALLING 2
+
+enum 
+{
+    TENV_NOOP, 
+    TENV_LEFT, 
+    TENV_RIGHT, 
+    TENV_ROTATE, 
+    TENV_DOWN, 
+    TENV_DROP, 
+    TENV_ACTIONS
+}; 
+
+typedef struct TENV TENV; 
+
+// threads <= 1 steps every game on the calling thread
+TENV *tenv_create(int n, int threads, unsigned int seed); 
+void tenv_destroy(TENV *env); 
+
+int tenv_size(const TENV *env); 
+
+void tenv_reset(TENV *env, unsigned char *obs); 
+void tenv_step(TENV *env, const unsigned char *actions, 
+        unsigned char *obs, float *rewards, unsigned char *dones); 
+
+#endif
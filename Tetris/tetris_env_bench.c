@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tetris_env.h"
+
+// usage: tetris_env_bench [games] [threads] [steps]
+int main(int argc, char **argv)
+{
+    int n = argc >= 2 ? atoi(argv[1]) : 1024; 
+    int threads = argc >= 3 ? atoi(argv[2]) : 1; 
+    int steps = argc >= 4 ? atoi(argv[3]) : 2000; 
+
+    TENV *env = tenv_create(n, threads, 1); 
+    unsigned char *actions = (unsigned char *) malloc(n); 
+    unsigned char *obs = (unsigned char *) malloc((size_t) n * TENV_OBS_SIZE); 
+    float *rewards = (float *) malloc(n * sizeof(float)); 
+    unsigned char *dones = (unsigned char *) malloc(n); 
+    tenv_reset(env, obs); 
+
+    unsigned int seed = 7; 
+    long games = 0; 
+    double total = 0; 
+    struct timespec beg, end; 
+    clock_gettime(CLOCK_MONOTONIC, &beg); 
+    for(int s = 0; s < steps; ++s)
+    {
+        for(int e = 0; e < n; ++e)
+            actions[e] = rand_r(&seed) % TENV_ACTIONS; 
+        tenv_step(env, actions, obs, rewards, dones); 
+        for(int e = 0; e < n; ++e)
+        {
+            games += dones[e]; 
+            total += rewards[e]; 
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); 
+
+    double secs = (end.tv_sec - beg.tv_sec) + (end.tv_nsec - beg.tv_nsec) * 1e-9; 
+    printf("%d games x %d steps on %d threads: %.3fs, %.0f steps/s\n", 
+            n, steps, threads, secs, (double) n * steps / secs); 
+    printf("%ld games finished, %.0f total reward\n", games, total); 
+
+    tenv_destroy(env); 
+    free(actions); 
+    free(obs); 
+    free(rewards); 
+    free(dones); 
+}
@@ -1,7 +1,42 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "tetromino.h"
 
+// Every tetromino is one block whose row pointers point at its own cells. 
+// Deleted blocks go on a free list and are handed out again, so after the 
+// first few pieces a game does not touch the heap. Not thread safe. 
+typedef struct TBLOCK
+{
+    int *rows[4];       // must be first, a TETROMINO points here
+    int cells[4][4]; 
+    struct TBLOCK *next; 
+}TBLOCK; 
+
+#define POOL_CHUNK 16
+
+static TBLOCK *g_free; 
+
+// cells are zero
+static TETROMINO new_block()
+{
+    if(!g_free)
+    {
+        TBLOCK *chunk = (TBLOCK *) malloc(POOL_CHUNK * sizeof(TBLOCK)); 
+        for(int k = 0; k < POOL_CHUNK; ++k)
+        {
+            chunk[k].next = g_free; 
+            g_free = &chunk[k]; 
+        }
+    }
+    TBLOCK *b = g_free; 
+    g_free = b->next; 
+    memset(b->cells, 0, sizeof(b->cells)); 
+    for(int i = 0; i < 4; ++i)
+        b->rows[i] = b->cells[i]; 
+    return b->rows; 
+}
+
 int const g_tetrominos[7][4][4] = {
     // I
     {{1, 1, 1, 1}, 
@@ -49,21 +84,18 @@ int const g_tetrominos[7][4][4] = {
 TETROMINO get_copy(int n)
 {
     n %= sizeof(g_tetrominos) / sizeof(g_tetrominos[0]); 
-    TETROMINO copy = (TETROMINO) malloc(4 * sizeof(int *)); 
+    TETROMINO copy = new_block(); 
     for(int i = 0; i < 4; ++i)
-    {
-        copy[i] = (int *) malloc(4 * sizeof(int)); 
         for(int j = 0; j < 4; ++j)
             copy[i][j] = g_tetrominos[n][i][j]; 
-    }
     return copy; 
 }
 
 void del_copy(TETROMINO copy)
 {
-    for(int i = 0; i < 4; ++i)
-        free(copy[i]); 
-    free(copy); 
+    TBLOCK *b = (TBLOCK *) copy; 
+    b->next = g_free; 
+    g_free = b; 
 }
 
 int get_height(TETROMINO tetromino)
@@ -96,9 +128,7 @@ int get_width(TETROMINO tetromino)
 
 TETROMINO rotate(TETROMINO tetromino)
 {
-    TETROMINO rotated = (TETROMINO) calloc(4, sizeof(int *)); 
-    for(int i = 0; i < 4; ++i)
-        rotated[i] = (int *) calloc(4, sizeof(int)); 
+    TETROMINO rotated = new_block(); 
 
     int shift = get_width(tetromino) - 1; 
     for(int i = 0; i < 4; ++i)
@@ -108,3 +138,54 @@ TETROMINO rotate(TETROMINO tetromino)
 
     return rotated; 
 }
+
+TMASK get_mask(TETROMINO tetromino)
+{
+    TMASK mask = 0; 
+    for(int i = 0; i < 4; ++i)
+        for(int j = 0; j < 4; ++j)
+            if(tetromino[i][j])
+                mask |= 1 << (4*i + j); 
+    return mask; 
+}
+
+TMASK get_mask_n(int n)
+{
+    n %= sizeof(g_tetrominos) / sizeof(g_tetrominos[0]); 
+    TMASK mask = 0; 
+    for(int i = 0; i < 4; ++i)
+        for(int j = 0; j < 4; ++j)
+            if(g_tetrominos[n][i][j])
+                mask |= 1 << (4*i + j); 
+    return mask; 
+}
+
+int mask_height(TMASK mask)
+{
+    int h = 0; 
+    while(h < 4 && (mask >> 4*h) & 0xF) 
+        ++h; 
+    return h; 
+}
+
+int mask_width(TMASK mask)
+{
+    // fold all rows onto the first one
+    int cols = (mask | mask >> 4 | mask >> 8 | mask >> 12) & 0xF; 
+    int w = 0; 
+    while(w < 4 && (cols >> w) & 1)
+        ++w; 
+    return w; 
+}
+
+// same as rotate() but without touching the heap
+TMASK rotate_mask(TMASK mask)
+{
+    TMASK rotated = 0; 
+    int shift = mask_width(mask) - 1; 
+    for(int i = 0; i < 4; ++i)
+        for(int j = 0; j < 4; ++j)
+            if(mask & (1 << (4*i + j)))
+                rotated |= 1 << (4*(shift-j) + i); 
+    return rotated; 
+}
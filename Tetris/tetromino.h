@@ -3,6 +3,11 @@
 
 typedef int ** TETROMINO; 
 
+// 4x4 bitmask, cell (i, j) is bit 4*i + j 
+typedef unsigned short TMASK; 
+
+#define TETROMINO_COUNT 7
+
 TETROMINO get_copy(int n); 
 void del_copy(TETROMINO copy); 
 
@@ -11,4 +16,10 @@ int get_width(TETROMINO tetromino);
 
 TETROMINO rotate(TETROMINO tetromino); 
 
+TMASK get_mask(TETROMINO tetromino); 
+TMASK get_mask_n(int n); 
+int mask_height(TMASK mask); 
+int mask_width(TMASK mask); 
+TMASK rotate_mask(TMASK mask); 
+
 #endif
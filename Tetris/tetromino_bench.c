@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "board.h"
+#include "tetromino.h"
+
+// Micro-benchmarks for tetromino.c, reports ns/op and heap allocations/op. 
+// Linked with -Wl,--wrap so every malloc, calloc and realloc is counted. 
+//
+// usage: tetromino_bench [iterations]
+
+void *__real_malloc(size_t size); 
+void *__real_calloc(size_t n, size_t size); 
+void *__real_realloc(void *p, size_t size); 
+
+unsigned long g_allocs; 
+
+void *__wrap_malloc(size_t size)
+{
+    ++g_allocs; 
+    return __real_malloc(size); 
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    ++g_allocs; 
+    return __real_calloc(n, size); 
+}
+
+void *__wrap_realloc(void *p, size_t size)
+{
+    ++g_allocs; 
+    return __real_realloc(p, size); 
+}
+
+// keeps the compiler from dropping the work
+volatile int g_sink; 
+
+double get_time()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + t.tv_nsec * 1e-9; 
+}
+
+void report(const char *name, long ops, double secs, unsigned long allocs)
+{
+    printf("%-20s %10.1f ns/op %8.2f allocs/op\n", 
+            name, secs * 1e9 / ops, (double) allocs / ops); 
+}
+
+#define BENCH(name, ops, body) \
+    do { \
+        unsigned long allocs = g_allocs; \
+        double beg = get_time(); \
+        for(long it = 0; it < (ops); ++it) { body; } \
+        double secs = get_time() - beg; \
+        report(name, ops, secs, g_allocs - allocs); \
+    } while(0)
+
+int main(int argc, char **argv)
+{
+    long n = argc >= 2 ? atol(argv[1]) : 1000000; 
+
+    TETROMINO pieces[TETROMINO_COUNT][4]; 
+    TMASK masks[TETROMINO_COUNT][4]; 
+    for(int p = 0; p < TETROMINO_COUNT; ++p)
+    {
+        pieces[p][0] = get_copy(p); 
+        for(int r = 1; r < 4; ++r)
+            pieces[p][r] = rotate(pieces[p][r-1]); 
+        for(int r = 0; r < 4; ++r)
+            masks[p][r] = get_mask(pieces[p][r]); 
+    }
+
+    // a ragged stack so the collision checks do real work
+    BOARD_ROW rows[20] = { 0 }; 
+    for(int i = 10; i < 20; ++i)
+        rows[i] = 0x3FF & ~(1u << (i * 7 % 10)); 
+
+    BENCH("get_copy+del_copy", n, {
+        TETROMINO t = get_copy(it); 
+        g_sink += t[0][0]; 
+        del_copy(t); 
+    }); 
+    BENCH("rotate+del_copy", n, {
+        TETROMINO t = rotate(pieces[it % 7][it & 3]); 
+        g_sink += t[0][0]; 
+        del_copy(t); 
+    }); 
+    BENCH("get_width", n, g_sink += get_width(pieces[it % 7][it & 3])); 
+    BENCH("get_height", n, g_sink += get_height(pieces[it % 7][it & 3])); 
+    BENCH("get_mask", n, g_sink += get_mask(pieces[it % 7][it & 3])); 
+    BENCH("rotate_mask", n, g_sink += rotate_mask(masks[it % 7][it & 3])); 
+    BENCH("fits TETROMINO", n, 
+        g_sink += board_fits(rows, 20, 10, get_mask(pieces[it % 7][it & 3]), it % 18, it % 8)); 
+    BENCH("fits TMASK", n, 
+        g_sink += board_fits(rows, 20, 10, masks[it % 7][it & 3], it % 18, it % 8)); 
+
+    for(int p = 0; p < TETROMINO_COUNT; ++p)
+        for(int r = 0; r < 4; ++r)
+            del_copy(pieces[p][r]); 
+    return 0; 
+}
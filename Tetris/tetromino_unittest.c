@@ -0,0 +1,164 @@
+#include <stdio.h>
+
+#include "board.h"
+#include "check.h"
+#include "tetromino.h"
+
+// Non-interactive checks for tetromino.c, exits non-zero on failure. 
+// tetromino_test is the interactive viewer. 
+
+const char g_names[] = "IOTLJSZ"; 
+
+// [piece][rotation] = { width, height }
+const int g_sizes[7][4][2] = {
+    { {4, 1}, {1, 4}, {4, 1}, {1, 4} },     // I
+    { {2, 2}, {2, 2}, {2, 2}, {2, 2} },     // O
+    { {3, 2}, {2, 3}, {3, 2}, {2, 3} },     // T
+    { {2, 3}, {3, 2}, {2, 3}, {3, 2} },     // L
+    { {2, 3}, {3, 2}, {2, 3}, {3, 2} },     // J
+    { {3, 2}, {2, 3}, {3, 2}, {2, 3} },     // S
+    { {3, 2}, {2, 3}, {3, 2}, {2, 3} }      // Z
+}; 
+
+// [piece][rotation], rows top to bottom 
+const char *g_shapes[7][4][4] = {
+    { {"####", "", "", ""}, {"#", "#", "#", "#"}, 
+      {"####", "", "", ""}, {"#", "#", "#", "#"} }, 
+    { {"##", "##", "", ""}, {"##", "##", "", ""}, 
+      {"##", "##", "", ""}, {"##", "##", "", ""} }, 
+    { {"###", ".#.", "", ""}, {"#.", "##", "#.", ""}, 
+      {".#.", "###", "", ""}, {".#", "##", ".#", ""} }, 
+    { {"#.", "#.", "##", ""}, {"..#", "###", "", ""}, 
+      {"##", ".#", ".#", ""}, {"###", "#..", "", ""} }, 
+    { {".#", ".#", "##", ""}, {"###", "..#", "", ""}, 
+      {"##", "#.", "#.", ""}, {"#..", "###", "", ""} }, 
+    { {".##", "##.", "", ""}, {"#.", "##", ".#", ""}, 
+      {".##", "##.", "", ""}, {"#.", "##", ".#", ""} }, 
+    { {"##.", ".##", "", ""}, {".#", "##", "#.", ""}, 
+      {"##.", ".##", "", ""}, {".#", "##", "#.", ""} } 
+}; 
+
+int matches(TETROMINO t, const char *shape[4])
+{
+    for(int i = 0; i < 4; ++i)
+    {
+        int len = 0; 
+        while(shape[i][len]) ++len; 
+        for(int j = 0; j < 4; ++j)
+        {
+            int want = j < len && shape[i][j] == '#'; 
+            if(!!t[i][j] != want) return 0; 
+        }
+    }
+    return 1; 
+}
+
+int count_cells(TETROMINO t)
+{
+    int n = 0; 
+    for(int i = 0; i < 4; ++i)
+        for(int j = 0; j < 4; ++j)
+            n += !!t[i][j]; 
+    return n; 
+}
+
+void test_get_copy()
+{
+    for(int n = 0; n < TETROMINO_COUNT; ++n)
+    {
+        TETROMINO t = get_copy(n); 
+        CHECK(matches(t, g_shapes[n][0]), "piece %c", g_names[n]); 
+        CHECK(count_cells(t) == 4, "piece %c", g_names[n]); 
+
+        // writing to a copy must not leak into the next one
+        t[3][3] = 1; 
+        TETROMINO u = get_copy(n); 
+        CHECK(u[3][3] == 0, "piece %c", g_names[n]); 
+        del_copy(t); 
+        del_copy(u); 
+
+        // indices wrap around 
+        t = get_copy(n + TETROMINO_COUNT); 
+        CHECK(matches(t, g_shapes[n][0]), "piece %c wrapped", g_names[n]); 
+        del_copy(t); 
+    }
+}
+
+void test_rotate()
+{
+    for(int n = 0; n < TETROMINO_COUNT; ++n)
+    {
+        TETROMINO t = get_copy(n); 
+        for(int r = 0; r < 4; ++r)
+        {
+            CHECK(matches(t, g_shapes[n][r]), "piece %c rotation %d", g_names[n], r); 
+            CHECK(get_width(t) == g_sizes[n][r][0], 
+                    "piece %c rotation %d width %d", g_names[n], r, get_width(t)); 
+            CHECK(get_height(t) == g_sizes[n][r][1], 
+                    "piece %c rotation %d height %d", g_names[n], r, get_height(t)); 
+
+            TETROMINO rotated = rotate(t); 
+            CHECK(count_cells(rotated) == 4, "piece %c rotation %d", g_names[n], r); 
+            CHECK(get_width(rotated) == get_height(t), "piece %c rotation %d", g_names[n], r); 
+            CHECK(get_height(rotated) == get_width(t), "piece %c rotation %d", g_names[n], r); 
+            del_copy(t); 
+            t = rotated; 
+        }
+        // four turns bring it back
+        CHECK(matches(t, g_shapes[n][0]), "piece %c", g_names[n]); 
+        del_copy(t); 
+    }
+}
+
+void test_masks()
+{
+    for(int n = 0; n < TETROMINO_COUNT; ++n)
+    {
+        TETROMINO t = get_copy(n); 
+        TMASK m = get_mask_n(n); 
+        for(int r = 0; r < 4; ++r)
+        {
+            CHECK(get_mask(t) == m, "piece %c rotation %d", g_names[n], r); 
+            CHECK(mask_width(m) == get_width(t), "piece %c rotation %d", g_names[n], r); 
+            CHECK(mask_height(m) == get_height(t), "piece %c rotation %d", g_names[n], r); 
+
+            TETROMINO rotated = rotate(t); 
+            del_copy(t); 
+            t = rotated; 
+            m = rotate_mask(m); 
+        }
+        del_copy(t); 
+    }
+}
+
+void test_collision()
+{
+    BOARD_ROW rows[20] = { 0 }; 
+    TMASK i = get_mask_n(0); 
+    TMASK o = get_mask_n(1); 
+
+    CHECK(board_fits(rows, 20, 10, i, 0, 0), "top left"); 
+    CHECK(board_fits(rows, 20, 10, i, 19, 6), "bottom right"); 
+    CHECK(!board_fits(rows, 20, 10, i, 0, 7), "past the right wall"); 
+    CHECK(!board_fits(rows, 20, 10, i, 0, -1), "past the left wall"); 
+    CHECK(!board_fits(rows, 20, 10, o, 19, 0), "past the floor"); 
+    CHECK(board_drop(rows, 20, 10, o, 0, 4) == 18, "drop to floor"); 
+
+    board_place(rows, o, 18, 4); 
+    CHECK(!board_fits(rows, 20, 10, i, 18, 2), "overlap"); 
+    CHECK(board_drop(rows, 20, 10, i, 0, 3) == 17, "drop onto stack"); 
+
+    rows[19] = 0x3FF; 
+    CHECK(board_clear_lines(rows, 20, 10) == 1, "one full line"); 
+    CHECK(rows[19] == 0x30 && rows[18] == 0, "rows shift down"); 
+}
+
+int main()
+{
+    test_get_copy(); 
+    test_rotate(); 
+    test_masks(); 
+    test_collision(); 
+
+    return check_report(); 
+}
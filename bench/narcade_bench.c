@@ -0,0 +1,378 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "board.h"
+#include "life.h"
+#include "solver.h"
+#include "tetromino.h"
+#include "threats.h"
+
+// Fixed, seeded workloads for the hot path of every game. A benchmark runs a
+// batch of ops per sample and reports the median and p99 time per op over the
+// samples, ops per second at the median and heap allocations per op, counted
+// by alloc.h.
+//
+// -j writes the results as JSON, -b compares them with a file written by -j
+// and exits with 1 when anything got slower than the threshold or allocates
+// more.
+
+#define SEED 12345
+#define MAX_SAMPLES 100000
+#define MAX_NAME 32
+
+// keeps the compiler from dropping the work
+volatile long g_sink; 
+
+double get_time()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + t.tv_nsec * 1e-9; 
+}
+
+// Game of Life, a random 64x64 grid
+
+#define LIFE_SIZE 64
+
+void life_setup()
+{
+    srand(SEED); 
+    rows = cols = LIFE_SIZE; 
+    grid = create_grid(rows, cols, 0.5); 
+}
+
+void life_step(long ops)
+{
+    for(long i = 0; i < ops; ++i)
+        g_sink += step(); 
+}
+
+void life_teardown()
+{
+    delete_grid(grid); 
+}
+
+// Tetris, every piece and rotation on a ragged 20x10 stack
+
+#define WELL_ROWS 20
+#define WELL_COLS 10
+
+TMASK g_masks[TETROMINO_COUNT][4]; 
+BOARD_ROW g_well[WELL_ROWS]; 
+BOARD_ROW g_full_well[WELL_ROWS]; 
+
+void tetris_setup()
+{
+    for(int p = 0; p < TETROMINO_COUNT; ++p)
+    {
+        g_masks[p][0] = get_mask_n(p); 
+        for(int r = 1; r < 4; ++r)
+            g_masks[p][r] = rotate_mask(g_masks[p][r-1]); 
+    }
+    memset(g_well, 0, sizeof(g_well)); 
+    for(int i = 10; i < WELL_ROWS; ++i)
+        g_well[i] = 0x3FF & ~(1u << (i * 7 % 10)); 
+
+    // every third row of the stack is full
+    memcpy(g_full_well, g_well, sizeof(g_well)); 
+    for(int i = 10; i < WELL_ROWS; i += 3)
+        g_full_well[i] = 0x3FF; 
+}
+
+void tetris_fits(long ops)
+{
+    for(long i = 0; i < ops; ++i)
+        g_sink += board_fits(g_well, WELL_ROWS, WELL_COLS, g_masks[i % 7][i & 3], i % 18, i % 8); 
+}
+
+void tetris_clear(long ops)
+{
+    BOARD_ROW rows[WELL_ROWS]; 
+    for(long i = 0; i < ops; ++i)
+    {
+        memcpy(rows, g_full_well, sizeof(rows)); 
+        g_sink += board_clear_lines(rows, WELL_ROWS, WELL_COLS); 
+    }
+}
+
+// the pieces tetris.c creates, turns and deletes while one of them falls
+void tetris_piece(long ops)
+{
+    for(long i = 0; i < ops; ++i)
+    {
+        TETROMINO t = get_copy(i); 
+        TETROMINO rot = rotate(t); 
+        del_copy(t); 
+        t = rot; 
+        rot = rotate(t); 
+        g_sink += get_mask(t) + get_mask(rot); 
+        del_copy(rot); 
+        del_copy(t); 
+    }
+}
+
+void tetris_placements(long ops)
+{
+    PLACEMENT out[MAX_PLACEMENTS]; 
+    for(long i = 0; i < ops; ++i)
+        g_sink += board_placements(g_well, WELL_ROWS, WELL_COLS, g_masks[i % 7], out); 
+}
+
+// Connect 4, random positions with no win on the board yet
+
+#define C4_POSITIONS 256
+#define C4_DEPTH 8
+#define C4_TT_ENTRIES (1 << 16)
+
+POSITION g_positions[C4_POSITIONS]; 
+TTABLE *g_tt; 
+
+void c4_setup()
+{
+    unsigned int seed = SEED; 
+    for(int i = 0; i < C4_POSITIONS; ++i)
+    {
+        POSITION *pos = &g_positions[i]; 
+        pos_init(pos); 
+        int plies = 6 + rand_r(&seed) % 20; 
+        while(pos->moves < plies && !pos_is_full(pos))
+        {
+            int col = rand_r(&seed) % BOARD_COLS; 
+            if(!pos_can_play(pos, col)) continue; 
+            int player = pos_player(pos); 
+            pos_play(pos, col); 
+            if(pos_is_win(pos->boards[player]))
+            {
+                pos_undo(pos, col); 
+                break; 
+            }
+        }
+    }
+    g_tt = tt_create(C4_TT_ENTRIES); 
+}
+
+void c4_teardown()
+{
+    tt_destroy(g_tt); 
+}
+
+void c4_win(long ops)
+{
+    for(long i = 0; i < ops; ++i)
+        g_sink += pos_is_win(g_positions[i % C4_POSITIONS].boards[i & 1]); 
+}
+
+void c4_threats(long ops)
+{
+    THREATS t; 
+    for(long i = 0; i < ops; ++i)
+    {
+        threats_analyze(&g_positions[i % C4_POSITIONS], &t); 
+        g_sink += t.non_losing; 
+    }
+}
+
+// a fresh table every time so a search does not depend on the ones before it
+void c4_search(long ops)
+{
+    static long next; 
+    SEARCH_LIMITS limits = { .max_depth = C4_DEPTH, .threads = 1 }; 
+    SEARCH_RESULT result; 
+    for(long i = 0; i < ops; ++i)
+    {
+        tt_clear(g_tt); 
+        search(&g_positions[next++ % C4_POSITIONS], g_tt, &limits, &result); 
+        g_sink += result.move; 
+    }
+}
+
+typedef struct BENCH
+{
+    const char *name; 
+    long ops;               // per sample
+    void (*setup)(); 
+    void (*run)(long ops); 
+    void (*teardown)(); 
+}BENCH; 
+
+BENCH benches[] =
+{
+    { "life_step", 1, life_setup, life_step, life_teardown }, 
+    { "tetris_fits", 1000, tetris_setup, tetris_fits, NULL }, 
+    { "tetris_clear", 1000, tetris_setup, tetris_clear, NULL }, 
+    { "tetris_piece", 1000, tetris_setup, tetris_piece, NULL }, 
+    { "tetris_placements", 20, tetris_setup, tetris_placements, NULL }, 
+    { "c4_win", 1000, c4_setup, c4_win, c4_teardown }, 
+    { "c4_threats", 1000, c4_setup, c4_threats, c4_teardown }, 
+    { "c4_search", 1, c4_setup, c4_search, c4_teardown }, 
+}; 
+
+#define BENCH_COUNT (int) (sizeof(benches) / sizeof(benches[0]))
+
+typedef struct RESULT
+{
+    char name[MAX_NAME]; 
+    double median_ns, p99_ns;   // per op
+    double ops_per_sec; 
+    double allocs, bytes;       // per op
+}RESULT; 
+
+int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b; 
+    return x < y ? -1 : x > y; 
+}
+
+void run_bench(const BENCH *b, int samples, RESULT *r)
+{
+    static double ns[MAX_SAMPLES]; 
+    if(b->setup) b->setup(); 
+    b->run(b->ops);     // warm up
+
+    unsigned long allocs = alloc_count(), bytes = alloc_bytes(); 
+    for(int s = 0; s < samples; ++s)
+    {
+        double beg = get_time(); 
+        b->run(b->ops); 
+        ns[s] = (get_time() - beg) * 1e9 / b->ops; 
+    }
+    long ops = b->ops * samples; 
+    r->allocs = (double) (alloc_count() - allocs) / ops; 
+    r->bytes = (double) (alloc_bytes() - bytes) / ops; 
+    if(b->teardown) b->teardown(); 
+
+    qsort(ns, samples, sizeof(double), cmp_double); 
+    snprintf(r->name, MAX_NAME, "%s", b->name); 
+    r->median_ns = ns[samples / 2]; 
+    r->p99_ns = ns[(samples * 99 + 99) / 100 - 1]; 
+    r->ops_per_sec = r->median_ns > 0 ? 1e9 / r->median_ns : 0; 
+}
+
+// one benchmark per line so the baseline can be read back with sscanf
+int write_json(const char *path, const RESULT *results, int n)
+{
+    FILE *f = fopen(path, "w"); 
+    if(!f)
+    {
+        perror(path); 
+        return 0; 
+    }
+    fprintf(f, "[\n"); 
+    for(int i = 0; i < n; ++i)
+    {
+        const RESULT *r = &results[i]; 
+        fprintf(f, "  {\"name\": \"%s\", \"median_ns\": %.3f, \"p99_ns\": %.3f, "
+                "\"ops_per_sec\": %.0f, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f}%s\n", 
+                r->name, r->median_ns, r->p99_ns, r->ops_per_sec, r->allocs, r->bytes, 
+                i + 1 < n ? "," : ""); 
+    }
+    fprintf(f, "]\n"); 
+    fclose(f); 
+    return 1; 
+}
+
+int read_json(const char *path, RESULT *results, int max)
+{
+    FILE *f = fopen(path, "r"); 
+    if(!f)
+    {
+        perror(path); 
+        return -1; 
+    }
+    char line[512]; 
+    int n = 0; 
+    while(n < max && fgets(line, sizeof(line), f))
+    {
+        RESULT *r = &results[n]; 
+        if(sscanf(line, " {\"name\": \"%31[^\"]\", \"median_ns\": %lf, \"p99_ns\": %lf, "
+                    "\"ops_per_sec\": %lf, \"allocs_per_op\": %lf, \"bytes_per_op\": %lf", 
+                    r->name, &r->median_ns, &r->p99_ns, &r->ops_per_sec, &r->allocs, &r->bytes) == 6)
+            ++n; 
+    }
+    fclose(f); 
+    return n; 
+}
+
+// returns how many benchmarks got slower by more than threshold percent or
+// allocate more
+int compare(const RESULT *results, int n, const RESULT *base, int nbase, double threshold)
+{
+    int worse = 0; 
+    printf("\n%-20s %12s %12s %8s %8s\n", "vs baseline", "median ns", "was", "change", "p99"); 
+    for(int i = 0; i < n; ++i)
+    {
+        const RESULT *r = &results[i], *b = NULL; 
+        for(int j = 0; j < nbase && !b; ++j)
+            if(!strcmp(base[j].name, r->name)) b = &base[j]; 
+        if(!b || b->median_ns <= 0)
+        {
+            printf("%-20s %12.1f %12s\n", r->name, r->median_ns, "-"); 
+            continue; 
+        }
+        double change = (r->median_ns / b->median_ns - 1) * 100; 
+        double p99 = (r->p99_ns / b->p99_ns - 1) * 100; 
+        const char *verdict = ""; 
+        if(change > threshold) verdict = "slower"; 
+        else if(change < -threshold) verdict = "faster"; 
+        if(r->allocs > b->allocs) verdict = "more allocations"; 
+        if(change > threshold || r->allocs > b->allocs) ++worse; 
+        printf("%-20s %12.1f %12.1f %+7.1f%% %+7.1f%% %s\n", 
+                r->name, r->median_ns, b->median_ns, change, p99, verdict); 
+    }
+    return worse; 
+}
+
+int main(int argc, char **argv)
+{
+    int samples = 200; 
+    const char *filter = NULL, *json = NULL, *baseline = NULL; 
+    double threshold = 10; 
+    int opt; 
+    while((opt = getopt(argc, argv, "s:f:j:b:t:")) != -1)
+    {
+        switch(opt)
+        {
+            case 's': samples = atoi(optarg); break; 
+            case 'f': filter = optarg; break; 
+            case 'j': json = optarg; break; 
+            case 'b': baseline = optarg; break; 
+            case 't': threshold = atof(optarg); break; 
+            default:
+                fprintf(stderr, "usage: %s [-s samples] [-f name] [-j file] [-b file] [-t percent]\n", argv[0]); 
+                fprintf(stderr, "  -s n     samples per benchmark, default 200\n"); 
+                fprintf(stderr, "  -f name  only benchmarks whose name contains name\n"); 
+                fprintf(stderr, "  -j file  write the results as JSON\n"); 
+                fprintf(stderr, "  -b file  compare with results written by -j\n"); 
+                fprintf(stderr, "  -t pct   change in the median that counts, default 10\n"); 
+                return 1; 
+        }
+    }
+    if(samples < 1 || samples > MAX_SAMPLES) return 1; 
+
+    RESULT results[BENCH_COUNT]; 
+    int n = 0; 
+    printf("%-20s %12s %12s %14s %10s %10s\n", "benchmark", "median ns", "p99 ns", "ops/s", "allocs/op", "bytes/op"); 
+    for(int i = 0; i < BENCH_COUNT; ++i)
+    {
+        if(filter && !strstr(benches[i].name, filter)) continue; 
+        RESULT *r = &results[n++]; 
+        run_bench(&benches[i], samples, r); 
+        printf("%-20s %12.1f %12.1f %14.0f %10.2f %10.1f\n", 
+                r->name, r->median_ns, r->p99_ns, r->ops_per_sec, r->allocs, r->bytes); 
+        fflush(stdout); 
+    }
+
+    if(json && !write_json(json, results, n)) return 1; 
+    if(baseline)
+    {
+        RESULT base[BENCH_COUNT]; 
+        int nbase = read_json(baseline, base, BENCH_COUNT); 
+        if(nbase < 0) return 1; 
+        return compare(results, n, base, nbase, threshold) ? 1 : 0; 
+    }
+    return 0; 
+}
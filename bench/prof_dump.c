@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "prof.h"
+
+// Reads a trace a game wrote with NARCADE_TRACE=file. Prints the average,
+// median, p99 and max of every zone, then the frames that took more than a
+// few times the median or allocated, or every frame with -a.
+
+const char *prof_zone_names[PROF_ZONES] = PROF_ZONE_NAMES; 
+
+int cmp_float(const void *a, const void *b)
+{
+    float x = *(const float *) a, y = *(const float *) b; 
+    return x < y ? -1 : x > y; 
+}
+
+float frame_us(const PROF_RECORD *r)
+{
+    float total = 0; 
+    for(int z = 0; z < PROF_ZONES; ++z)
+        total += r->us[z]; 
+    return total; 
+}
+
+// what can be summarized, after the zones
+enum
+{
+    COL_FRAME = PROF_ZONES, 
+    COL_BYTES, 
+    COL_ALLOCS
+}; 
+
+float value(const PROF_RECORD *r, int col)
+{
+    switch(col)
+    {
+        case COL_FRAME: return frame_us(r); 
+        case COL_BYTES: return r->bytes; 
+        case COL_ALLOCS: return r->allocs; 
+        default: return r->us[col]; 
+    }
+}
+
+// returns the median
+float summarize(const char *name, const PROF_RECORD *records, long n, int col, float *tmp)
+{
+    double sum = 0; 
+    for(long i = 0; i < n; ++i)
+    {
+        tmp[i] = value(&records[i], col); 
+        sum += tmp[i]; 
+    }
+    qsort(tmp, n, sizeof(float), cmp_float); 
+    printf("%-8s %10.1f %10.1f %10.1f %10.1f\n", name, sum / n, tmp[n / 2], 
+            tmp[(n * 99 + 99) / 100 - 1], tmp[n - 1]); 
+    return tmp[n / 2]; 
+}
+
+void print_record(const PROF_RECORD *r, long i)
+{
+    printf("%8ld %10.3f", i, r->time); 
+    for(int z = 0; z < PROF_ZONES; ++z)
+        printf(" %10.1f", r->us[z]); 
+    printf(" %10.1f %8u %8u %10u\n", frame_us(r), r->bytes, r->allocs, r->alloc_bytes); 
+}
+
+int main(int argc, char **argv)
+{
+    int all = 0; 
+    double factor = 4; 
+    int opt; 
+    while((opt = getopt(argc, argv, "as:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'a': all = 1; break; 
+            case 's': factor = atof(optarg); break; 
+            default:
+                fprintf(stderr, "usage: %s [-a] [-s factor] file\n", argv[0]); 
+                fprintf(stderr, "  -a         every frame, not only the spikes\n"); 
+                fprintf(stderr, "  -s factor  a spike takes factor times the median frame, default 4\n"); 
+                return 1; 
+        }
+    }
+    if(optind >= argc)
+    {
+        fprintf(stderr, "usage: %s [-a] [-s factor] file\n", argv[0]); 
+        return 1; 
+    }
+
+    const char *path = argv[optind]; 
+    FILE *f = fopen(path, "rb"); 
+    if(!f)
+    {
+        perror(path); 
+        return 1; 
+    }
+    PROF_HEADER h; 
+    if(fread(&h, sizeof(h), 1, f) != 1 || h.magic != PROF_MAGIC
+            || h.zones != PROF_ZONES || h.record_size != sizeof(PROF_RECORD))
+    {
+        fprintf(stderr, "%s: not a trace of this version\n", path); 
+        return 1; 
+    }
+
+    long n = 0, cap = 1024; 
+    PROF_RECORD *records = (PROF_RECORD *) malloc(cap * sizeof(PROF_RECORD)); 
+    while(fread(&records[n], sizeof(PROF_RECORD), 1, f) == 1)
+        if(++n == cap)
+        {
+            cap *= 2; 
+            records = (PROF_RECORD *) realloc(records, cap * sizeof(PROF_RECORD)); 
+        }
+    fclose(f); 
+    if(n == 0)
+    {
+        printf("%s: no frames\n", path); 
+        return 0; 
+    }
+
+    float *tmp = (float *) malloc(n * sizeof(float)); 
+    printf("%ld frames over %.1f s\n\n", n, records[n-1].time - records[0].time); 
+    printf("%-8s %10s %10s %10s %10s\n", "us", "avg", "median", "p99", "max"); 
+    for(int z = 0; z < PROF_ZONES; ++z)
+        summarize(prof_zone_names[z], records, n, z, tmp); 
+    float limit = summarize("frame", records, n, COL_FRAME, tmp) * factor; 
+    summarize("bytes", records, n, COL_BYTES, tmp); 
+    summarize("allocs", records, n, COL_ALLOCS, tmp); 
+
+    // the first frame also pays for setting the game up
+    long allocating = 0; 
+    for(long i = 1; i < n; ++i)
+        allocating += records[i].allocs > 0; 
+    printf("\n%ld frames after the first allocated\n", allocating); 
+
+    printf("\n%8s %10s", "frame", "time s"); 
+    for(int z = 0; z < PROF_ZONES; ++z)
+        printf(" %10s", prof_zone_names[z]); 
+    printf(" %10s %8s %8s %10s\n", "total", "bytes", "allocs", "heap bytes"); 
+    for(long i = 0; i < n; ++i)
+        if(all || frame_us(&records[i]) > limit || records[i].allocs)
+            print_record(&records[i], i); 
+
+    free(tmp); 
+    free(records); 
+    return 0; 
+}
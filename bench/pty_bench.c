@@ -0,0 +1,428 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Runs a game under a pseudo-terminal and types a script of keys into it, the
+// way a user at a terminal would, so what curses costs is measured along with
+// the game. Every key is timed from its write to the first byte the game sends
+// back, and all the output is counted, in total and in bursts, a burst being
+// bytes that arrive less than a gap apart, about one frame.
+//
+// A script has one key or key sequence per line, after the delay in ms since
+// the line before:
+//
+//     # comment
+//     500 <right>
+//     120 \e[A
+//
+// Names in angle brackets are the keys below, \e \r \n \t \\ and \xHH work as
+// in C. A game that animates on its own also sends frames nobody asked for,
+// the first of them after a key counts as its response.
+//
+// -j appends the results as one JSON line, -b compares them with the line of
+// the same name in a file written by -j and exits with 1 when the median
+// latency or the bytes per key grew by more than the threshold.
+
+#define MAX_EVENTS 4096
+#define MAX_KEYS 16
+#define MAX_NAME 32
+#define READ_SIZE 65536
+
+// a latency change smaller than this is the scheduler, not the game
+#define LATENCY_NOISE_MS 1.0
+
+typedef struct EVENT
+{
+    double at;                  // seconds after the start
+    char keys[MAX_KEYS]; 
+    int len; 
+}EVENT; 
+
+typedef struct KEY_NAME
+{
+    const char *name; 
+    const char *seq; 
+}KEY_NAME; 
+
+// what xterm sends with the keypad on, as curses turns it on
+const KEY_NAME key_names[] = {
+    { "up", "\033OA" }, 
+    { "down", "\033OB" }, 
+    { "right", "\033OC" }, 
+    { "left", "\033OD" }, 
+    { "f1", "\033OP" }, 
+    { "enter", "\r" }, 
+    { "esc", "\033" }, 
+    { "space", " " }, 
+    { "tab", "\t" }, 
+}; 
+
+#define KEY_NAME_COUNT (int) (sizeof(key_names) / sizeof(key_names[0]))
+
+typedef struct RESULT
+{
+    char name[MAX_NAME]; 
+    int keys, answered; 
+    double median_ms, p99_ms, max_ms; 
+    long bytes, bursts, max_burst; 
+    double seconds; 
+}RESULT; 
+
+EVENT g_events[MAX_EVENTS]; 
+int g_count; 
+
+// latency of every key, negative until it is answered
+double g_sent[MAX_EVENTS]; 
+double g_latency[MAX_EVENTS]; 
+int g_waiting = -1; 
+
+long g_bytes, g_bursts, g_burst, g_max_burst; 
+double g_last_read; 
+double g_gap = 0.002; 
+
+double get_time()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + t.tv_nsec * 1e-9; 
+}
+
+int hex(char c)
+{
+    if(c >= '0' && c <= '9') return c - '0'; 
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10; 
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10; 
+    return -1; 
+}
+
+// returns the length of the decoded keys, or -1
+int decode(const char *s, char *out)
+{
+    int n = 0; 
+    while(*s && *s != '\n')
+    {
+        const char *seq = NULL; 
+        char c = *s++; 
+        if(c == '<' && strchr(s, '>'))
+        {
+            int len = strchr(s, '>') - s; 
+            for(int i = 0; i < KEY_NAME_COUNT && !seq; ++i)
+                if((int) strlen(key_names[i].name) == len && !strncmp(key_names[i].name, s, len))
+                    seq = key_names[i].seq; 
+            if(!seq) return -1; 
+            s += len + 1; 
+        }
+        else if(c == '\\')
+        {
+            c = *s++; 
+            switch(c)
+            {
+                case 'e': c = '\033'; break; 
+                case 'r': c = '\r'; break; 
+                case 'n': c = '\n'; break; 
+                case 't': c = '\t'; break; 
+                case '\\': break; 
+                case 'x':
+                    if(hex(s[0]) < 0 || hex(s[1]) < 0) return -1; 
+                    c = hex(s[0]) * 16 + hex(s[1]); 
+                    s += 2; 
+                    break; 
+                default: return -1; 
+            }
+        }
+        char one[2] = { c, 0 }; 
+        if(!seq) seq = one; 
+        int len = seq == one ? 1 : strlen(seq); 
+        if(n + len > MAX_KEYS) return -1; 
+        memcpy(out + n, seq, len); 
+        n += len; 
+    }
+    return n; 
+}
+
+int read_script(const char *path)
+{
+    FILE *f = fopen(path, "r"); 
+    if(!f)
+    {
+        perror(path); 
+        return 0; 
+    }
+    char line[256]; 
+    double at = 0; 
+    int number = 0; 
+    while(fgets(line, sizeof(line), f))
+    {
+        ++number; 
+        int ms, skip; 
+        if(sscanf(line, " %n", &skip) >= 0 && (line[skip] == '#' || line[skip] == 0)) continue; 
+        if(sscanf(line, "%d %n", &ms, &skip) != 1 || ms < 0 || g_count == MAX_EVENTS)
+        {
+            fprintf(stderr, "%s:%d: expected a delay in ms and keys\n", path, number); 
+            fclose(f); 
+            return 0; 
+        }
+        EVENT *e = &g_events[g_count]; 
+        at += ms / 1000.0; 
+        e->at = at; 
+        e->len = decode(line + skip, e->keys); 
+        if(e->len <= 0)
+        {
+            fprintf(stderr, "%s:%d: no keys or an unknown one\n", path, number); 
+            fclose(f); 
+            return 0; 
+        }
+        ++g_count; 
+    }
+    fclose(f); 
+    return 1; 
+}
+
+// reads what the game sends until the deadline, returns 0 once it is gone
+int pump(int fd, double deadline)
+{
+    static char buf[READ_SIZE]; 
+    while(1)
+    {
+        double left = deadline - get_time(); 
+        if(left < 0) left = 0; 
+        struct timespec t = { (time_t) left, (long) ((left - (time_t) left) * 1e9) }; 
+        struct pollfd p = { fd, POLLIN, 0 }; 
+        int ready = ppoll(&p, 1, &t, NULL); 
+        if(ready < 0 && errno == EINTR) continue; 
+        if(ready <= 0) return 1; 
+
+        ssize_t n = read(fd, buf, sizeof(buf)); 
+        if(n < 0 && errno == EINTR) continue; 
+        // EIO once the game has closed its end
+        if(n <= 0) return 0; 
+
+        double now = get_time(); 
+        if(g_waiting >= 0)
+        {
+            g_latency[g_waiting] = now - g_sent[g_waiting]; 
+            g_waiting = -1; 
+        }
+        if(g_bursts == 0 || now - g_last_read > g_gap)
+        {
+            ++g_bursts; 
+            g_burst = 0; 
+        }
+        g_burst += n; 
+        if(g_burst > g_max_burst) g_max_burst = g_burst; 
+        g_bytes += n; 
+        g_last_read = now; 
+    }
+}
+
+int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b; 
+    return x < y ? -1 : x > y; 
+}
+
+void summarize(RESULT *r, double seconds)
+{
+    static double sorted[MAX_EVENTS]; 
+    int n = 0; 
+    for(int i = 0; i < g_count; ++i)
+        if(g_latency[i] >= 0) sorted[n++] = g_latency[i] * 1e3; 
+    qsort(sorted, n, sizeof(double), cmp_double); 
+    r->keys = g_count; 
+    r->answered = n; 
+    r->median_ms = n ? sorted[n / 2] : 0; 
+    r->p99_ms = n ? sorted[(n * 99 + 99) / 100 - 1] : 0; 
+    r->max_ms = n ? sorted[n - 1] : 0; 
+    r->bytes = g_bytes; 
+    r->bursts = g_bursts; 
+    r->max_burst = g_max_burst; 
+    r->seconds = seconds; 
+}
+
+void print_result(const RESULT *r, int rows, int cols)
+{
+    printf("%s at %dx%d, %d keys over %.1f s, %d answered\n", 
+            r->name, cols, rows, r->keys, r->seconds, r->answered); 
+    printf("  latency   %8.2f ms median %8.2f ms p99 %8.2f ms max\n", 
+            r->median_ms, r->p99_ms, r->max_ms); 
+    printf("  output    %8ld bytes     %8.0f bytes/s  %8.0f bytes/key\n", 
+            r->bytes, r->bytes / r->seconds, r->keys ? (double) r->bytes / r->keys : 0); 
+    printf("  bursts    %8ld           %8.0f bytes avg  %8ld bytes max\n", 
+            r->bursts, r->bursts ? (double) r->bytes / r->bursts : 0, r->max_burst); 
+}
+
+int write_json(const char *path, const RESULT *r)
+{
+    FILE *f = fopen(path, "a"); 
+    if(!f)
+    {
+        perror(path); 
+        return 0; 
+    }
+    fprintf(f, "{\"name\": \"%s\", \"keys\": %d, \"answered\": %d, \"median_ms\": %.3f, "
+            "\"p99_ms\": %.3f, \"max_ms\": %.3f, \"bytes\": %ld, \"bursts\": %ld, \"seconds\": %.3f}\n", 
+            r->name, r->keys, r->answered, r->median_ms, r->p99_ms, r->max_ms, 
+            r->bytes, r->bursts, r->seconds); 
+    fclose(f); 
+    return 1; 
+}
+
+// returns 1 and fills base if path has a line for name
+int read_json(const char *path, const char *name, RESULT *base)
+{
+    FILE *f = fopen(path, "r"); 
+    if(!f)
+    {
+        perror(path); 
+        return 0; 
+    }
+    char line[512]; 
+    int found = 0; 
+    while(!found && fgets(line, sizeof(line), f))
+    {
+        RESULT *b = base; 
+        if(sscanf(line, " {\"name\": \"%31[^\"]\", \"keys\": %d, \"answered\": %d, \"median_ms\": %lf, "
+                    "\"p99_ms\": %lf, \"max_ms\": %lf, \"bytes\": %ld, \"bursts\": %ld, \"seconds\": %lf", 
+                    b->name, &b->keys, &b->answered, &b->median_ms, &b->p99_ms, &b->max_ms, 
+                    &b->bytes, &b->bursts, &b->seconds) == 9)
+            found = !strcmp(b->name, name); 
+    }
+    fclose(f); 
+    if(!found) fprintf(stderr, "%s: nothing for %s\n", path, name); 
+    return found; 
+}
+
+// returns true if the median latency or the bytes per key got worse by more
+// than threshold percent
+int compare(const RESULT *r, const RESULT *b, double threshold)
+{
+    double latency = b->median_ms > 0 ? (r->median_ms / b->median_ms - 1) * 100 : 0; 
+    double per_key = r->keys ? (double) r->bytes / r->keys : 0; 
+    double was = b->keys ? (double) b->bytes / b->keys : 0; 
+    double bytes = was > 0 ? (per_key / was - 1) * 100 : 0; 
+    printf("  vs baseline latency %+.1f%% bytes/key %+.1f%%", latency, bytes); 
+    int worse = (latency > threshold && r->median_ms - b->median_ms > LATENCY_NOISE_MS)
+            || bytes > threshold; 
+    printf("%s\n", worse ? " worse" : ""); 
+    return worse; 
+}
+
+void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [options] -s script -- game [args]\n", prog); 
+    fprintf(stderr, "  -s file  keys to type, see pty_bench.c\n"); 
+    fprintf(stderr, "  -r rows  terminal size, default 24x80\n"); 
+    fprintf(stderr, "  -c cols\n"); 
+    fprintf(stderr, "  -T term  TERM for the game, default xterm-256color\n"); 
+    fprintf(stderr, "  -g ms    gap that ends a burst of output, default 2\n"); 
+    fprintf(stderr, "  -w ms    how long to wait for the game to exit after the script, default 2000\n"); 
+    fprintf(stderr, "  -n name  name of the results, default the game\n"); 
+    fprintf(stderr, "  -j file  append the results as JSON\n"); 
+    fprintf(stderr, "  -b file  compare with results written by -j\n"); 
+    fprintf(stderr, "  -t pct   change that counts, default 25\n"); 
+}
+
+int main(int argc, char **argv)
+{
+    int rows = 24, cols = 80; 
+    const char *script = NULL, *term = "xterm-256color", *name = NULL; 
+    const char *json = NULL, *baseline = NULL; 
+    double wait = 2, threshold = 25; 
+    int opt; 
+    while((opt = getopt(argc, argv, "s:r:c:T:g:w:n:j:b:t:")) != -1)
+    {
+        switch(opt)
+        {
+            case 's': script = optarg; break; 
+            case 'r': rows = atoi(optarg); break; 
+            case 'c': cols = atoi(optarg); break; 
+            case 'T': term = optarg; break; 
+            case 'g': g_gap = atof(optarg) / 1000; break; 
+            case 'w': wait = atof(optarg) / 1000; break; 
+            case 'n': name = optarg; break; 
+            case 'j': json = optarg; break; 
+            case 'b': baseline = optarg; break; 
+            case 't': threshold = atof(optarg); break; 
+            default:
+                usage(argv[0]); 
+                return 1; 
+        }
+    }
+    if(!script || optind >= argc || rows < 1 || cols < 1)
+    {
+        usage(argv[0]); 
+        return 1; 
+    }
+    if(!read_script(script)) return 1; 
+    if(!name)
+    {
+        name = strrchr(argv[optind], '/'); 
+        name = name ? name + 1 : argv[optind]; 
+    }
+
+    struct winsize size = { rows, cols, 0, 0 }; 
+    int fd; 
+    pid_t pid = forkpty(&fd, NULL, NULL, &size); 
+    if(pid < 0)
+    {
+        perror("forkpty"); 
+        return 1; 
+    }
+    if(pid == 0)
+    {
+        setenv("TERM", term, 1); 
+        execvp(argv[optind], argv + optind); 
+        perror(argv[optind]); 
+        _exit(127); 
+    }
+
+    for(int i = 0; i < g_count; ++i)
+        g_latency[i] = -1; 
+    double start = get_time(); 
+    int alive = 1; 
+    for(int i = 0; i < g_count && alive; ++i)
+    {
+        alive = pump(fd, start + g_events[i].at); 
+        if(!alive) break; 
+        g_sent[i] = get_time(); 
+        g_waiting = i; 
+        if(write(fd, g_events[i].keys, g_events[i].len) != g_events[i].len) alive = 0; 
+    }
+    double end = get_time() + wait; 
+    while(alive && get_time() < end)
+        alive = pump(fd, end); 
+    double seconds = get_time() - start; 
+
+    int status = 0; 
+    if(alive)
+    {
+        fprintf(stderr, "%s did not exit, killing it\n", name); 
+        kill(pid, SIGKILL); 
+    }
+    waitpid(pid, &status, 0); 
+    close(fd); 
+
+    RESULT r; 
+    snprintf(r.name, sizeof(r.name), "%s", name); 
+    summarize(&r, seconds); 
+    print_result(&r, rows, cols); 
+    if(json && !write_json(json, &r)) return 1; 
+
+    int failed = alive || !WIFEXITED(status) || WEXITSTATUS(status) != 0; 
+    if(baseline)
+    {
+        RESULT base; 
+        if(!read_json(baseline, name, &base)) return 1; 
+        failed |= compare(&r, &base, threshold); 
+    }
+    return failed; 
+}
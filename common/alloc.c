@@ -0,0 +1,43 @@
+#include <stdatomic.h>
+
+#include "alloc.h"
+
+void *__real_malloc(size_t size); 
+void *__real_calloc(size_t n, size_t size); 
+void *__real_realloc(void *p, size_t size); 
+
+static atomic_ulong g_count, g_bytes; 
+
+static void count(size_t size)
+{
+    atomic_fetch_add_explicit(&g_count, 1, memory_order_relaxed); 
+    atomic_fetch_add_explicit(&g_bytes, size, memory_order_relaxed); 
+}
+
+void *__wrap_malloc(size_t size)
+{
+    count(size); 
+    return __real_malloc(size); 
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    count(n * size); 
+    return __real_calloc(n, size); 
+}
+
+void *__wrap_realloc(void *p, size_t size)
+{
+    count(size); 
+    return __real_realloc(p, size); 
+}
+
+unsigned long alloc_count()
+{
+    return atomic_load_explicit(&g_count, memory_order_relaxed); 
+}
+
+unsigned long alloc_bytes()
+{
+    return atomic_load_explicit(&g_bytes, memory_order_relaxed); 
+}
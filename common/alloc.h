@@ -0,0 +1,13 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stddef.h>
+
+// Counts the heap allocations of every object linked with
+// -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc, from any thread. Calls made
+// inside shared libraries, curses among them, are not seen.
+
+unsigned long alloc_count(); 
+unsigned long alloc_bytes(); 
+
+#endif
@@ -0,0 +1,45 @@
+#include <ncurses.h>
+
+#include "arcade.h"
+#include "prof.h"
+#include "term.h"
+
+void arcade_setup()
+{
+    cbreak(); 
+    noecho(); 
+    curs_set(0); 
+    keypad(stdscr, TRUE); 
+    if(has_colors())
+    {
+        start_color(); 
+        use_default_colors(); 
+    }
+}
+
+void arcade_play(const ARCADE_GAME *game)
+{
+    game->start(); 
+    int playing = 1; 
+    while(playing)
+    {
+        // ticks that draw nothing add their time to the next frame
+        int drawn; 
+        PROF_SCOPE(PROF_RENDER) drawn = game->render(); 
+        if(drawn) prof_frame(term_last_frame()); 
+        playing = game->tick(); 
+    }
+}
+
+void arcade_main(const ARCADE_GAME *game)
+{
+    term_open(); 
+    prof_init(); 
+    arcade_setup(); 
+    game->init(); 
+    arcade_play(game); 
+    game->shutdown(); 
+    prof_close(); 
+    term_close(); 
+    term_print_stats(stdout); 
+}
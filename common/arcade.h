@@ -0,0 +1,34 @@
+#ifndef ARCADE_H
+#define ARCADE_H
+
+// The hooks of a game, so one loop runs it on its own and in the launcher,
+// which opens the terminal once and keeps every game's windows and tables
+// warm between turns.
+//
+// init makes what the game keeps for the whole run, its windows, color pairs
+// and tables. start puts up a new game on a cleared screen. tick waits for a
+// key or the game's next timer and handles it, and returns 0 when the player
+// leaves. render draws the frame, ends it with term_frame and returns 0 if
+// nothing changed. shutdown frees what init made. The terminal is open from
+// before init until after shutdown.
+
+typedef struct ARCADE_GAME
+{
+    const char *name; 
+    void (*init)(); 
+    void (*start)(); 
+    int (*tick)(); 
+    int (*render)(); 
+    void (*shutdown)(); 
+}ARCADE_GAME; 
+
+// the curses modes every game expects, once after term_open
+void arcade_setup(); 
+
+// one game, from start until the player leaves
+void arcade_play(const ARCADE_GAME *game); 
+
+// a game on its own, from opening the terminal to printing the totals
+void arcade_main(const ARCADE_GAME *game); 
+
+#endif
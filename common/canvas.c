@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "canvas.h"
+
+// unchanged cells between two changes that are still sent as one run, cheaper
+// than moving the cursor again
+#define CANVAS_GAP 4
+
+#define UNKNOWN ((chtype) -1)
+
+struct CANVAS
+{
+    WINDOW *win; 
+    int rows, cols; 
+    chtype *front, *back; 
+}; 
+
+CANVAS *canvas_create(WINDOW *win)
+{
+    CANVAS *c = (CANVAS *) malloc(sizeof(CANVAS)); 
+    c->win = win; 
+    getmaxyx(win, c->rows, c->cols); 
+    c->front = (chtype *) malloc(c->rows * c->cols * sizeof(chtype)); 
+    c->back = (chtype *) malloc(c->rows * c->cols * sizeof(chtype)); 
+    canvas_clear(c); 
+    canvas_invalidate(c); 
+    return c; 
+}
+
+void canvas_destroy(CANVAS *c)
+{
+    if(!c) return; 
+    free(c->front); 
+    free(c->back); 
+    free(c); 
+}
+
+WINDOW *canvas_win(const CANVAS *c)
+{
+    return c->win; 
+}
+
+void canvas_clear(CANVAS *c)
+{
+    for(int i = 0; i < c->rows * c->cols; ++i)
+        c->back[i] = ' '; 
+}
+
+// clipped to the window
+void canvas_fill(CANVAS *c, int y, int x, int h, int w, chtype ch)
+{
+    if(y < 0)
+    {
+        h += y; 
+        y = 0; 
+    }
+    if(x < 0)
+    {
+        w += x; 
+        x = 0; 
+    }
+    if(y + h > c->rows) h = c->rows - y; 
+    if(x + w > c->cols) w = c->cols - x; 
+    for(int i = 0; i < h; ++i)
+    {
+        chtype *row = c->back + (y + i) * c->cols + x; 
+        for(int j = 0; j < w; ++j)
+            row[j] = ch; 
+    }
+}
+
+void canvas_print(CANVAS *c, int y, int x, chtype attr, const char *s)
+{
+    if(y < 0 || y >= c->rows) return; 
+    chtype *row = c->back + y * c->cols; 
+    for(; *s && x < c->cols; ++s, ++x)
+        if(x >= 0) row[x] = (unsigned char) *s | attr; 
+}
+
+void canvas_box(CANVAS *c)
+{
+    int h = c->rows, w = c->cols; 
+    canvas_fill(c, 0, 1, 1, w - 2, ACS_HLINE); 
+    canvas_fill(c, h - 1, 1, 1, w - 2, ACS_HLINE); 
+    canvas_fill(c, 1, 0, h - 2, 1, ACS_VLINE); 
+    canvas_fill(c, 1, w - 1, h - 2, 1, ACS_VLINE); 
+    canvas_fill(c, 0, 0, 1, 1, ACS_ULCORNER); 
+    canvas_fill(c, 0, w - 1, 1, 1, ACS_URCORNER); 
+    canvas_fill(c, h - 1, 0, 1, 1, ACS_LLCORNER); 
+    canvas_fill(c, h - 1, w - 1, 1, 1, ACS_LRCORNER); 
+}
+
+void canvas_invalidate(CANVAS *c)
+{
+    for(int i = 0; i < c->rows * c->cols; ++i)
+        c->front[i] = UNKNOWN; 
+}
+
+int canvas_flush(CANVAS *c)
+{
+    int written = 0; 
+    for(int i = 0; i < c->rows; ++i)
+    {
+        chtype *front = c->front + i * c->cols; 
+        chtype *back = c->back + i * c->cols; 
+        if(!memcmp(front, back, c->cols * sizeof(chtype))) continue; 
+
+        int j = 0; 
+        while(j < c->cols)
+        {
+            if(front[j] == back[j])
+            {
+                ++j; 
+                continue; 
+            }
+            // extend the run over short gaps, end is one past its last change
+            int end = j + 1; 
+            for(int k = end; k < c->cols && k - end < CANVAS_GAP; ++k)
+                if(front[k] != back[k]) end = k + 1; 
+            mvwaddchnstr(c->win, i, j, back + j, end - j); 
+            memcpy(front + j, back + j, (end - j) * sizeof(chtype)); 
+            written += end - j; 
+            j = end; 
+        }
+    }
+    if(written) wnoutrefresh(c->win); 
+    return written; 
+}
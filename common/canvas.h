@@ -0,0 +1,30 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <ncurses.h>
+
+// A frame buffer over a curses window. Games draw the whole frame into the
+// back buffer every time, the flush compares it with the front buffer, which
+// is what the window already holds, and sends only the runs of cells that
+// changed. Nothing reads the window back.
+
+typedef struct CANVAS CANVAS; 
+
+// the first flush repaints the whole window
+CANVAS *canvas_create(WINDOW *win); 
+void canvas_destroy(CANVAS *c); 
+WINDOW *canvas_win(const CANVAS *c); 
+
+void canvas_clear(CANVAS *c); 
+void canvas_fill(CANVAS *c, int y, int x, int h, int w, chtype ch); 
+void canvas_print(CANVAS *c, int y, int x, chtype attr, const char *s); 
+void canvas_box(CANVAS *c); 
+
+// forget what is on screen, after something else drew over the window
+void canvas_invalidate(CANVAS *c); 
+
+// copies the changes to the window and marks it for the next doupdate,
+// returns the cells written
+int canvas_flush(CANVAS *c); 
+
+#endif
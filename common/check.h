@@ -0,0 +1,30 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// Checks for the headless tests. A failed CHECK prints where and why and
+// counts, the test keeps going; main returns check_report(), non-zero when
+// anything failed. Include from the test's own file only.
+
+#define CHECK(cond, ...) \
+    do { \
+        ++g_checks; \
+        if(!(cond)) \
+        { \
+            ++g_failures; \
+            printf("%s:%d: %s: ", __FILE__, __LINE__, #cond); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while(0)
+
+static int g_checks, g_failures; 
+
+static int check_report()
+{
+    printf("%d/%d checks passed\n", g_checks - g_failures, g_checks); 
+    return g_failures != 0; 
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "canvas.h"
+#include "prof.h"
+
+// bucket k holds frames of [2^(k-1), 2^k) microseconds, bucket 0 under 1us
+#define PROF_BUCKETS 24
+
+#define OVERLAY_LINES 9
+#define OVERLAY_COLS 42
+
+const char *prof_zone_names[PROF_ZONES] = PROF_ZONE_NAMES; 
+
+// one for every zone and one for the whole frame
+typedef struct SERIES
+{
+    unsigned long count; 
+    double sum, max, last; 
+    unsigned long hist[PROF_BUCKETS]; 
+}SERIES; 
+
+static SERIES g_series[PROF_ZONES + 1]; 
+static double g_start[PROF_ZONES]; 
+static double g_frame[PROF_ZONES];      // time in every zone so far this frame
+static double g_init; 
+static unsigned long g_bytes; 
+
+// heap allocations, as of the end of the last frame
+static unsigned long g_allocs, g_alloc_bytes; 
+static unsigned long g_last_allocs, g_max_allocs; 
+
+static FILE *g_trace; 
+
+static WINDOW *g_win; 
+static CANVAS *g_overlay; 
+
+static double now()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + t.tv_nsec * 1e-9; 
+}
+
+void prof_init()
+{
+    g_init = now(); 
+    g_allocs = alloc_count(); 
+    g_alloc_bytes = alloc_bytes(); 
+    const char *path = getenv(PROF_TRACE_ENV); 
+    if(!path || !*path) return; 
+    g_trace = fopen(path, "wb"); 
+    if(!g_trace) return; 
+    PROF_HEADER h = { PROF_MAGIC, PROF_ZONES, sizeof(PROF_RECORD) }; 
+    fwrite(&h, sizeof(h), 1, g_trace); 
+}
+
+unsigned prof_seed()
+{
+    const char *seed = getenv(PROF_SEED_ENV); 
+    return seed && *seed ? (unsigned) atol(seed) : (unsigned) time(0); 
+}
+
+void prof_close()
+{
+    if(g_trace) fclose(g_trace); 
+    g_trace = NULL; 
+    canvas_destroy(g_overlay); 
+    if(g_win) delwin(g_win); 
+    g_overlay = NULL; 
+    g_win = NULL; 
+}
+
+void prof_begin(int zone)
+{
+    g_start[zone] = now(); 
+}
+
+void prof_end(int zone)
+{
+    g_frame[zone] += now() - g_start[zone]; 
+}
+
+static void add(SERIES *s, double us)
+{
+    int k = 0; 
+    while(k < PROF_BUCKETS - 1 && us >= (double) (1ul << k)) ++k; 
+    ++s->hist[k]; 
+    ++s->count; 
+    s->sum += us; 
+    s->last = us; 
+    if(us > s->max) s->max = us; 
+}
+
+// upper bound of the bucket the 99th percentile falls in
+static double p99(const SERIES *s)
+{
+    unsigned long seen = 0, want = s->count - s->count / 100; 
+    for(int k = 0; k < PROF_BUCKETS; ++k)
+    {
+        seen += s->hist[k]; 
+        if(seen >= want)
+        {
+            double bound = (double) (1ul << k); 
+            return bound < s->max ? bound : s->max; 
+        }
+    }
+    return s->max; 
+}
+
+static void print_series(int y, const char *name, const SERIES *s)
+{
+    char line[OVERLAY_COLS]; 
+    snprintf(line, sizeof(line), "%-7s %7.0f %7.0f %7.0f %7.0f", name, s->last, 
+            s->count ? s->sum / s->count : 0, p99(s), s->max); 
+    canvas_print(g_overlay, y, 2, A_NORMAL, line); 
+}
+
+static void draw_overlay()
+{
+    canvas_clear(g_overlay); 
+    canvas_box(g_overlay); 
+    canvas_print(g_overlay, 0, 2, A_NORMAL, " frame times in us, P hides "); 
+    canvas_print(g_overlay, 1, 2, A_BOLD, "           last     avg     p99     max"); 
+    for(int z = 0; z < PROF_ZONES; ++z)
+        print_series(2 + z, prof_zone_names[z], &g_series[z]); 
+    print_series(2 + PROF_ZONES, "frame", &g_series[PROF_ZONES]); 
+
+    char line[OVERLAY_COLS]; 
+    unsigned long frames = g_series[PROF_ZONES].count; 
+    snprintf(line, sizeof(line), "%lu frames, %.0f bytes per frame", frames, 
+            frames ? (double) g_bytes / frames : 0); 
+    canvas_print(g_overlay, 3 + PROF_ZONES, 2, A_NORMAL, line); 
+    snprintf(line, sizeof(line), "%lu allocs last frame, %lu at most", 
+            g_last_allocs, g_max_allocs); 
+    canvas_print(g_overlay, 4 + PROF_ZONES, 2, A_NORMAL, line); 
+    canvas_flush(g_overlay); 
+}
+
+void prof_frame(long bytes)
+{
+    PROF_RECORD r; 
+    double total = 0; 
+    for(int z = 0; z < PROF_ZONES; ++z)
+    {
+        double us = g_frame[z] * 1e6; 
+        add(&g_series[z], us); 
+        r.us[z] = us; 
+        total += us; 
+        g_frame[z] = 0; 
+    }
+    add(&g_series[PROF_ZONES], total); 
+    g_bytes += bytes; 
+
+    unsigned long allocs = alloc_count(), alloc_size = alloc_bytes(); 
+    g_last_allocs = allocs - g_allocs; 
+    if(g_last_allocs > g_max_allocs) g_max_allocs = g_last_allocs; 
+    r.allocs = g_last_allocs; 
+    r.alloc_bytes = alloc_size - g_alloc_bytes; 
+    g_allocs = allocs; 
+    g_alloc_bytes = alloc_size; 
+
+    if(g_trace)
+    {
+        r.time = now() - g_init; 
+        r.bytes = bytes; 
+        fwrite(&r, sizeof(r), 1, g_trace); 
+    }
+    // goes out with the next frame
+    if(g_overlay) draw_overlay(); 
+}
+
+int prof_toggle_overlay()
+{
+    if(g_overlay)
+    {
+        canvas_destroy(g_overlay); 
+        delwin(g_win); 
+        g_overlay = NULL; 
+        g_win = NULL; 
+        return 0; 
+    }
+    int x = COLS > OVERLAY_COLS ? COLS - OVERLAY_COLS : 0; 
+    g_win = newwin(OVERLAY_LINES, OVERLAY_COLS, 0, x); 
+    g_overlay = canvas_create(g_win); 
+    draw_overlay(); 
+    return 1; 
+}
+
+void prof_refresh_overlay()
+{
+    if(!g_win) return; 
+    touchwin(g_win); 
+    wnoutrefresh(g_win); 
+}
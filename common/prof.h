@@ -0,0 +1,68 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+
+// Frame timing for the game loops. Code is timed in zones, a frame is all the
+// zones since the previous one, closed right after its doupdate. Every frame
+// goes into a log2 histogram per zone, which the overlay shows together with
+// the heap allocations of the frame, counted by alloc.h. With
+// NARCADE_TRACE=file in the environment every frame is also written to file,
+// prof_dump reads it back.
+
+enum
+{
+    PROF_INPUT, 
+    PROF_SIM, 
+    PROF_RENDER, 
+    PROF_ZONES
+}; 
+
+#define PROF_ZONE_NAMES { "input", "sim", "render" }
+
+// times the statement or block after it, which must not jump out
+#define PROF_SCOPE(zone) \
+    for(int prof_once_ = (prof_begin(zone), 1); prof_once_; prof_once_ = (prof_end(zone), 0))
+
+#define PROF_TRACE_ENV "NARCADE_TRACE"
+#define PROF_SEED_ENV "NARCADE_SEED"
+#define PROF_MAGIC 0x3230464f5250414eull    // "NAPROF02" on disk
+
+typedef struct PROF_HEADER
+{
+    uint64_t magic; 
+    uint32_t zones; 
+    uint32_t record_size; 
+}PROF_HEADER; 
+
+typedef struct PROF_RECORD
+{
+    double time;                // seconds since prof_init
+    float us[PROF_ZONES];       // time in every zone
+    uint32_t bytes;             // sent to the terminal
+    uint32_t allocs;            // heap allocations
+    uint32_t alloc_bytes;       // bytes asked for by them
+}PROF_RECORD; 
+
+extern const char *prof_zone_names[PROF_ZONES]; 
+
+void prof_init(); 
+void prof_close(); 
+
+void prof_begin(int zone); 
+void prof_end(int zone); 
+void prof_frame(long bytes); 
+
+// seed for the game's random numbers, NARCADE_SEED=n in the environment makes
+// runs repeatable, otherwise the time
+unsigned prof_seed(); 
+
+// returns true if the overlay is now shown, the game repaints what it covered
+// when it is hidden
+int prof_toggle_overlay(); 
+
+// marks the overlay to go out after whatever the game flushed this frame,
+// term_frame calls it right before doupdate
+void prof_refresh_overlay(); 
+
+#endif
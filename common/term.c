@@ -0,0 +1,142 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "prof.h"
+#include "term.h"
+
+// room for any frame, curses blocks on a full pipe until the pump empties it
+#define PIPE_SIZE (1 << 20)
+
+static int g_tty = -1;      // the real stdout while curses writes to the pipe
+static int g_pipe = -1;     // read end of the pipe
+static int g_counting; 
+static pthread_t g_pump; 
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER; 
+
+static unsigned long g_bytes, g_last, g_frames; 
+static long g_max, g_last_frame; 
+
+// copies what is in the pipe to the terminal, returns 0 once curses is gone,
+// the caller holds g_lock
+static int pump()
+{
+    char buf[4096]; 
+    ssize_t n; 
+    while((n = read(g_pipe, buf, sizeof(buf))) > 0)
+    {
+        g_bytes += n; 
+        for(ssize_t done = 0, k; done < n; done += k)
+            if((k = write(g_tty, buf + done, n - done)) <= 0) break; 
+    }
+    return n != 0; 
+}
+
+// output curses sends outside a frame, like the refresh inside wgetch, must
+// not wait for the next frame
+static void *pump_thread(void *arg)
+{
+    struct pollfd fd = { g_pipe, POLLIN, 0 }; 
+    int open = 1; 
+    while(open)
+    {
+        if(poll(&fd, 1, -1) < 0) continue; 
+        pthread_mutex_lock(&g_lock); 
+        open = pump(); 
+        pthread_mutex_unlock(&g_lock); 
+    }
+    return NULL; 
+}
+
+static int redirect()
+{
+    int fds[2]; 
+    if(!isatty(STDOUT_FILENO) || !isatty(STDERR_FILENO) || pipe2(fds, O_NONBLOCK) < 0)
+        return 0; 
+
+    // only the read end stays non blocking
+    fcntl(fds[1], F_SETFL, 0); 
+    fcntl(fds[1], F_SETPIPE_SZ, PIPE_SIZE); 
+    fflush(stdout); 
+    g_tty = dup(STDOUT_FILENO); 
+    g_pipe = fds[0]; 
+    dup2(fds[1], STDOUT_FILENO); 
+    close(fds[1]); 
+    if(!pthread_create(&g_pump, NULL, pump_thread, NULL)) return 1; 
+
+    dup2(g_tty, STDOUT_FILENO); 
+    close(g_tty); 
+    close(g_pipe); 
+    g_tty = g_pipe = -1; 
+    return 0; 
+}
+
+void term_open()
+{
+    // with stdout on a pipe curses takes the modes and the size from stderr
+    g_counting = redirect(); 
+    if(g_counting) set_term(newterm(NULL, stdout, stdin)); 
+    else initscr(); 
+}
+
+void term_close()
+{
+    endwin(); 
+    if(g_tty < 0) return; 
+
+    // the pump reads to the end of the pipe once stdout is the terminal again
+    fflush(stdout); 
+    dup2(g_tty, STDOUT_FILENO); 
+    pthread_join(g_pump, NULL); 
+    close(g_tty); 
+    close(g_pipe); 
+    g_tty = g_pipe = -1; 
+}
+
+long term_frame()
+{
+    prof_refresh_overlay(); 
+    doupdate(); 
+    ++g_frames; 
+    if(g_tty < 0) return 0; 
+
+    pthread_mutex_lock(&g_lock); 
+    pump(); 
+    long bytes = g_bytes - g_last; 
+    g_last = g_bytes; 
+    pthread_mutex_unlock(&g_lock); 
+    if(bytes > g_max) g_max = bytes; 
+    g_last_frame = bytes; 
+    return bytes; 
+}
+
+long term_last_frame()
+{
+    return g_last_frame; 
+}
+
+unsigned long term_bytes()
+{
+    return g_bytes; 
+}
+
+unsigned long term_frames()
+{
+    return g_frames; 
+}
+
+long term_max_frame()
+{
+    return g_max; 
+}
+
+void term_print_stats(FILE *f)
+{
+    if(!g_counting || !g_frames) return; 
+    fprintf(f, "terminal output: %lu frames, %lu bytes, avg %.0f bytes, max %ld bytes per frame\n", 
+            g_frames, g_bytes, (double) g_last / g_frames, g_max); 
+}
@@ -0,0 +1,24 @@
+#ifndef TERM_H
+#define TERM_H
+
+#include <ncurses.h>
+
+// Starts and stops curses for every game. When stdout and stderr are both the
+// terminal, curses writes into a pipe that is copied to the terminal, so the
+// bytes it sends can be counted. Otherwise it runs as usual and counts nothing.
+
+void term_open(); 
+void term_close(); 
+
+// the single doupdate of a frame, returns the bytes sent since the last frame
+long term_frame(); 
+
+long term_last_frame(); 
+unsigned long term_bytes(); 
+unsigned long term_frames(); 
+long term_max_frame(); 
+
+// one line of totals, for after term_close
+void term_print_stats(FILE *f); 
+
+#endif